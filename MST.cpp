@@ -2,9 +2,467 @@
 #include <utility>
 #include <vector>
 #include <queue>
+#include <tuple>
+#include <array>
+#include <numeric>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <string>
+#include <functional>
+#include <fstream>
+#include <sys/resource.h>
 
 using namespace std;
 
+// Monotone radix heap for non-negative integer keys.
+// Keys popped are non-decreasing, so every pushed key shares a bit prefix
+// with the last popped key; bucket b holds keys whose highest bit differing
+// from `last` is bit b-1. push is O(1), pop is amortized O(log C).
+template <typename V>
+class RadixHeap {
+private:
+    static constexpr int BUCKETS = 65;  // bucket 0 = equal to last, 1..64 by bit
+
+    vector<pair<unsigned long long, V>> buckets[BUCKETS];
+    unsigned long long last = 0;
+    size_t size_ = 0;
+
+    static int bucketOf(unsigned long long key, unsigned long long last) {
+        return key == last ? 0 : 64 - __builtin_clzll(key ^ last);
+    }
+
+public:
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    void push(unsigned long long key, V value) {
+        buckets[bucketOf(key, last)].emplace_back(key, value);
+        ++size_;
+    }
+
+    pair<unsigned long long, V> pop() {
+        if (buckets[0].empty()) {
+            int b = 1;
+            while (buckets[b].empty()) ++b;
+
+            // Redistribute the first non-empty bucket around its minimum.
+            last = buckets[b][0].first;
+            for (auto& kv : buckets[b])
+                last = min(last, kv.first);
+            for (auto& kv : buckets[b])
+                buckets[bucketOf(kv.first, last)].push_back(kv);
+            buckets[b].clear();
+        }
+        auto top = buckets[0].back();
+        buckets[0].pop_back();
+        --size_;
+        return top;
+    }
+};
+
+// Reusable barrier for a fixed group of threads (generation counting).
+class Barrier {
+private:
+    mutex m;
+    condition_variable cv;
+    int count;
+    int waiting = 0;
+    int generation = 0;
+
+public:
+    explicit Barrier(int count) : count(count) {}
+
+    void wait() {
+        unique_lock<mutex> lock(m);
+        int gen = generation;
+        if (++waiting == count) {
+            waiting = 0;
+            ++generation;
+            cv.notify_all();
+        } else {
+            cv.wait(lock, [&] { return gen != generation; });
+        }
+    }
+};
+
+// Minimum spanning forest maintained under edge insertions.
+// The forest is kept in a link-cut tree where every forest edge is its own
+// node (carrying the weight) between its two endpoint vertices, so the
+// heaviest edge on a tree path is a path aggregate. Inserting (u, v, w):
+//   - u, v in different trees: link them, w joins the forest;
+//   - otherwise: find the heaviest edge on the u-v path; if it is heavier
+//     than w, cut it and link the new edge instead (cycle property).
+// Each insertion is O(log n) amortized; mst_weight() is O(1).
+class DynamicMST {
+private:
+    struct Node {
+        int ch[2] = {0, 0};
+        int p = 0;
+        bool rev = false;
+        int w = numeric_limits<int>::min();  // vertices never win a max query
+        int mx = 0;                          // node with max w in splay subtree
+    };
+
+    int n;                                   // number of vertices (nodes 1..n)
+    vector<Node> t;                          // t[0] is the null node
+    vector<tuple<int,int,int>> edgeOf;       // edge node -> (u, v, w)
+    vector<int> freeNodes;                   // recycled edge nodes
+    vector<int> splayPath;                   // scratch buffer for splay()
+    long long mst_weight_ = 0;
+    size_t forestEdges = 0;
+
+    bool isRoot(int x) const {
+        int p = t[x].p;
+        return p == 0 || (t[p].ch[0] != x && t[p].ch[1] != x);
+    }
+
+    void pull(int x) {
+        int best = x;
+        for (int c : t[x].ch)
+            if (c && t[t[c].mx].w > t[best].w) best = t[c].mx;
+        t[x].mx = best;
+    }
+
+    void push(int x) {
+        if (t[x].rev) {
+            for (int c : t[x].ch)
+                if (c) {
+                    swap(t[c].ch[0], t[c].ch[1]);
+                    t[c].rev = !t[c].rev;
+                }
+            t[x].rev = false;
+        }
+    }
+
+    void rotate(int x) {
+        int p = t[x].p, g = t[p].p;
+        int dir = t[p].ch[1] == x;
+        if (!isRoot(p)) t[g].ch[t[g].ch[1] == p] = x;
+        t[x].p = g;
+        t[p].ch[dir] = t[x].ch[!dir];
+        if (t[x].ch[!dir]) t[t[x].ch[!dir]].p = p;
+        t[x].ch[!dir] = p;
+        t[p].p = x;
+        pull(p);
+        pull(x);
+    }
+
+    void splay(int x) {
+        // Push pending reversals from the splay root down to x first.
+        splayPath.assign(1, x);
+        for (int y = x; !isRoot(y); y = t[y].p) splayPath.push_back(t[y].p);
+        for (auto it = splayPath.rbegin(); it != splayPath.rend(); ++it) push(*it);
+
+        while (!isRoot(x)) {
+            int p = t[x].p, g = t[p].p;
+            if (!isRoot(p))
+                rotate((t[g].ch[1] == p) == (t[p].ch[1] == x) ? p : x);
+            rotate(x);
+        }
+    }
+
+    void access(int x) {
+        for (int last = 0, y = x; y; last = y, y = t[y].p) {
+            splay(y);
+            t[y].ch[1] = last;
+            pull(y);
+        }
+        splay(x);
+    }
+
+    void makeRoot(int x) {
+        access(x);
+        swap(t[x].ch[0], t[x].ch[1]);
+        t[x].rev = !t[x].rev;
+    }
+
+    int findRoot(int x) {
+        access(x);
+        while (true) {
+            push(x);
+            if (!t[x].ch[0]) break;
+            x = t[x].ch[0];
+        }
+        splay(x);
+        return x;
+    }
+
+    void link(int x, int y) {
+        makeRoot(x);
+        t[x].p = y;
+    }
+
+    void cut(int x, int y) {
+        makeRoot(x);
+        access(y);
+        // x is now y's left child with no right subtree of its own.
+        t[y].ch[0] = 0;
+        t[x].p = 0;
+        pull(y);
+    }
+
+    int newEdgeNode(int u, int v, int w) {
+        int e;
+        if (!freeNodes.empty()) {
+            e = freeNodes.back();
+            freeNodes.pop_back();
+        } else {
+            e = (int)t.size();
+            t.emplace_back();
+            edgeOf.emplace_back();
+        }
+        t[e] = Node();
+        t[e].w = w;
+        t[e].mx = e;
+        edgeOf[e - n - 1] = {u, v, w};
+        return e;
+    }
+
+public:
+    DynamicMST(int n) : n(n), t(n + 1) {
+        for (int x = 1; x <= n; ++x) t[x].mx = x;
+    }
+
+    // Insert undirected edge (u, v, w). Returns true if the forest changed.
+    bool insertEdge(int u, int v, int w) {
+        if (u == v) return false;
+        int a = u + 1, b = v + 1;
+
+        if (findRoot(a) != findRoot(b)) {
+            int e = newEdgeNode(u, v, w);
+            link(a, e);
+            link(e, b);
+            mst_weight_ += w;
+            ++forestEdges;
+            return true;
+        }
+
+        // Same tree: the u-v path plus the new edge form a cycle.
+        makeRoot(a);
+        access(b);
+        int heaviest = t[b].mx;
+        if (t[heaviest].w <= w) return false;
+
+        auto [hu, hv, hw] = edgeOf[heaviest - n - 1];
+        cut(hu + 1, heaviest);
+        cut(heaviest, hv + 1);
+        freeNodes.push_back(heaviest);
+        mst_weight_ -= hw;
+
+        int e = newEdgeNode(u, v, w);
+        link(a, e);
+        link(e, b);
+        mst_weight_ += w;
+        return true;
+    }
+
+    bool connected(int u, int v) {
+        return findRoot(u + 1) == findRoot(v + 1);
+    }
+
+    // Total weight of the current minimum spanning forest, no recomputation.
+    long long mst_weight() const { return mst_weight_; }
+
+    size_t numEdges() const { return forestEdges; }
+
+    // Current forest edges as {u, v, weight}, same form as Graph::primMST.
+    vector<tuple<int,int,int>> edges() const {
+        vector<bool> freed(t.size(), false);
+        for (int e : freeNodes) freed[e] = true;
+        vector<tuple<int,int,int>> out;
+        for (int e = n + 1; e < (int)t.size(); ++e)
+            if (!freed[e]) out.push_back(edgeOf[e - n - 1]);
+        return out;
+    }
+};
+
+// k-d tree over a point cloud, used by euclideanMST. Every node records the
+// bounding box of its points and, during a Boruvka round, the component id
+// shared by all of its points (-1 if mixed), so whole subtrees that belong
+// to the query's own component are skipped.
+template <int D>
+class KdTree {
+public:
+    using Point = array<double, D>;
+
+    struct Node {
+        Point lo, hi;        // bounding box
+        int begin, end;      // range in idx[]
+        int left = -1, right = -1;
+        int comp = -1;
+    };
+
+    const vector<Point>& pts;
+    vector<int> idx;         // point ids, permuted so each node is a range
+    vector<Node> nodes;
+
+    static constexpr int LEAF_SIZE = 16;
+
+    explicit KdTree(const vector<Point>& pts) : pts(pts), idx(pts.size()) {
+        iota(idx.begin(), idx.end(), 0);
+        nodes.reserve(2 * pts.size() / LEAF_SIZE + 1);
+        if (!pts.empty()) build(0, (int)pts.size());
+    }
+
+    // Squared distance from p to the node's bounding box.
+    static double boxDist2(const Node& nd, const Point& p) {
+        double d2 = 0;
+        for (int k = 0; k < D; ++k) {
+            double d = max({0.0, nd.lo[k] - p[k], p[k] - nd.hi[k]});
+            d2 += d * d;
+        }
+        return d2;
+    }
+
+    static double dist2(const Point& a, const Point& b) {
+        double d2 = 0;
+        for (int k = 0; k < D; ++k) d2 += (a[k] - b[k]) * (a[k] - b[k]);
+        return d2;
+    }
+
+    // Bottom-up refresh of node component labels from per-point labels.
+    int labelComponents(const vector<int>& comp, int node = 0) {
+        Node& nd = nodes[node];
+        if (nd.left < 0) {
+            nd.comp = comp[idx[nd.begin]];
+            for (int i = nd.begin + 1; i < nd.end && nd.comp >= 0; ++i)
+                if (comp[idx[i]] != nd.comp) nd.comp = -1;
+        } else {
+            int l = labelComponents(comp, nd.left);
+            int r = labelComponents(comp, nd.right);
+            nodes[node].comp = (l == r) ? l : -1;
+        }
+        return nodes[node].comp;
+    }
+
+    // Nearest point to q outside component c, improving (best, bestJ) only
+    // when strictly closer (ties broken by smaller point id).
+    void nearestOutside(int q, int c, const vector<int>& comp,
+                        double& best, int& bestJ, int node = 0) const {
+        const Node& nd = nodes[node];
+        if (nd.comp == c || boxDist2(nd, pts[q]) > best) return;
+
+        if (nd.left < 0) {
+            for (int i = nd.begin; i < nd.end; ++i) {
+                int j = idx[i];
+                if (comp[j] == c) continue;
+                double d2 = dist2(pts[q], pts[j]);
+                if (d2 < best || (d2 == best && j < bestJ)) {
+                    best = d2;
+                    bestJ = j;
+                }
+            }
+            return;
+        }
+
+        // Visit the closer child first so `best` shrinks sooner.
+        int a = nd.left, b = nd.right;
+        if (boxDist2(nodes[b], pts[q]) < boxDist2(nodes[a], pts[q])) swap(a, b);
+        nearestOutside(q, c, comp, best, bestJ, a);
+        nearestOutside(q, c, comp, best, bestJ, b);
+    }
+
+private:
+    int build(int begin, int end) {
+        int id = (int)nodes.size();
+        nodes.push_back(Node());
+        Node nd;
+        nd.begin = begin;
+        nd.end = end;
+        nd.lo = nd.hi = pts[idx[begin]];
+        for (int i = begin; i < end; ++i)
+            for (int k = 0; k < D; ++k) {
+                nd.lo[k] = min(nd.lo[k], pts[idx[i]][k]);
+                nd.hi[k] = max(nd.hi[k], pts[idx[i]][k]);
+            }
+
+        if (end - begin > LEAF_SIZE) {
+            // Split at the median of the widest dimension.
+            int axis = 0;
+            for (int k = 1; k < D; ++k)
+                if (nd.hi[k] - nd.lo[k] > nd.hi[axis] - nd.lo[axis]) axis = k;
+            int mid = (begin + end) / 2;
+            nth_element(idx.begin() + begin, idx.begin() + mid, idx.begin() + end,
+                        [&](int a, int b) { return pts[a][axis] < pts[b][axis]; });
+            nd.left = build(begin, mid);
+            nd.right = build(mid, end);
+        }
+        nodes[id] = nd;
+        return id;
+    }
+};
+
+// Euclidean minimum spanning tree of a 2-D/3-D point cloud, without
+// materializing the O(n^2) complete graph. Boruvka rounds: every point asks
+// the k-d tree for its nearest neighbour in a different component (pruned by
+// the best edge found so far for its component), then each component's
+// cheapest outgoing edge is added. O(log n) rounds.
+// Returns {total length, edges} with edges as {u, v, length}.
+template <int D>
+pair<double, vector<tuple<int,int,double>>> euclideanMST(const vector<array<double, D>>& pts) {
+    int n = (int)pts.size();
+    double mst_weight = 0;
+    vector<tuple<int,int,double>> mst_edges;
+    if (n < 2) return {mst_weight, mst_edges};
+
+    KdTree<D> tree(pts);
+
+    vector<int> parent(n);
+    iota(parent.begin(), parent.end(), 0);
+    auto find = [&](int x) {
+        while (parent[x] != x) x = parent[x] = parent[parent[x]];
+        return x;
+    };
+
+    vector<int> comp(n);
+    vector<double> bestD(n);
+    vector<pair<int,int>> bestEdge(n);
+    int components = n;
+
+    while (components > 1) {
+        for (int i = 0; i < n; ++i) comp[i] = find(i);
+        tree.labelComponents(comp);
+        fill(bestD.begin(), bestD.end(), numeric_limits<double>::infinity());
+        fill(bestEdge.begin(), bestEdge.end(), make_pair(-1, -1));
+
+        for (int i = 0; i < n; ++i) {
+            int c = comp[i];
+            double best = bestD[c];
+            int j = -1;
+            tree.nearestOutside(i, c, comp, best, j);
+            if (j < 0) continue;
+
+            // Consistent tie-breaking keeps the union of chosen edges acyclic.
+            auto key = make_pair(min(i, j), max(i, j));
+            if (best < bestD[c] || (best == bestD[c] && key < bestEdge[c])) {
+                bestD[c] = best;
+                bestEdge[c] = key;
+            }
+        }
+
+        for (int c = 0; c < n; ++c) {
+            if (comp[c] != c || bestEdge[c].first < 0) continue;
+            auto [u, v] = bestEdge[c];
+            int ru = find(u), rv = find(v);
+            if (ru == rv) continue;
+            parent[ru] = rv;
+            --components;
+            double w = sqrt(bestD[c]);
+            mst_weight += w;
+            mst_edges.emplace_back(u, v, w);
+        }
+    }
+
+    return {mst_weight, mst_edges};
+}
+
 class Graph {
 private:
     int n;  // number of vertices
@@ -19,6 +477,16 @@ public:
         adj[v].push_back({u, w});
     }
 
+    int numVertices() const { return n; }
+
+    int degree(int u) const { return (int)adj[u].size(); }
+
+    long long numEdges() const {
+        long long m = 0;
+        for (auto &edges : adj) m += (long long)edges.size();
+        return m / 2;
+    }
+
     // Prim's Minimum Spanning Tree
     pair<long long, vector<tuple<int,int,int>>> primMST(int start = 0) {
         vector<bool> used(n, false);
@@ -53,9 +521,574 @@ public:
 
         return {mst_weight, mst_edges};
     }
+
+    // Minimum spanning forest that can then be updated edge by edge.
+    DynamicMST dynamicMST() const {
+        DynamicMST d(n);
+        for (int u = 0; u < n; ++u)
+            for (auto &[v, weight] : adj[u])
+                if (u < v) d.insertEdge(u, v, weight);
+        return d;
+    }
+
+    // Parallel connected components with a lock-free union-find.
+    // Threads take disjoint vertex ranges and union each edge's endpoints;
+    // roots are linked larger-id under smaller-id by CAS, so every component
+    // ends up labelled by its smallest vertex. Returns {count, comp}.
+    pair<int, vector<int>> connectedComponents(int threads = 0) const {
+        if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+        vector<atomic<int>> parent(n);
+        for (int v = 0; v < n; ++v) parent[v].store(v, memory_order_relaxed);
+
+        auto find = [&](int x) {
+            while (true) {
+                int p = parent[x].load(memory_order_relaxed);
+                if (p == x) return x;
+                int gp = parent[p].load(memory_order_relaxed);
+                // Path halving; losing this race is harmless.
+                if (gp != p) parent[x].compare_exchange_weak(p, gp, memory_order_relaxed);
+                x = gp;
+            }
+        };
+
+        auto forRange = [&](auto body) {
+            vector<thread> pool;
+            for (int t = 0; t < threads; ++t) {
+                int lo = (int)((long long)n * t / threads);
+                int hi = (int)((long long)n * (t + 1) / threads);
+                pool.emplace_back([=, &body] { for (int v = lo; v < hi; ++v) body(v); });
+            }
+            for (auto &th : pool) th.join();
+        };
+
+        forRange([&](int u) {
+            for (auto &[v, weight] : adj[u]) {
+                if (v <= u) continue;  // each undirected edge once
+                int a = u, b = v;
+                while (true) {
+                    a = find(a);
+                    b = find(b);
+                    if (a == b) break;
+                    if (a < b) swap(a, b);
+                    int expected = a;
+                    if (parent[a].compare_exchange_strong(expected, b)) break;
+                }
+            }
+        });
+
+        vector<int> comp(n);
+        forRange([&](int v) { comp[v] = find(v); });
+        int count = 0;
+        for (int v = 0; v < n; ++v)
+            if (comp[v] == v) ++count;
+        return {count, comp};
+    }
+
+    bool isConnected(int threads = 0) const {
+        return connectedComponents(threads).first <= 1;
+    }
+
+    // Direction-optimizing parallel BFS (Beamer et al.).
+    // Top-down steps expand the frontier and claim children with a CAS on
+    // parent[]; bottom-up steps let each unvisited vertex look for a parent
+    // in the frontier bitmap, which wins once the frontier touches a large
+    // share of the remaining edges. Every thread collects its own next
+    // frontier; thread 0 merges them and picks the direction between levels.
+    // Returns {depth, parent} with -1 for unreachable vertices.
+    pair<vector<int>, vector<int>> bfs(int source, int threads = 0) const {
+        static constexpr long long ALPHA = 14;  // top-down -> bottom-up
+        static constexpr long long BETA = 24;   // bottom-up -> top-down
+        if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+
+        vector<atomic<int>> parent(n);
+        for (int v = 0; v < n; ++v) parent[v].store(-1, memory_order_relaxed);
+        vector<int> depth(n, -1);
+        parent[source].store(source, memory_order_relaxed);
+        depth[source] = 0;
+
+        struct alignas(64) Local {
+            vector<int> next;
+            long long edges = 0;   // sum of degrees of vertices in next
+        };
+        vector<Local> local(threads);
+
+        vector<int> frontier{source};
+        vector<char> inFrontier(n, 0);   // dense frontier for bottom-up steps
+        vector<int> marked;              // vertices currently set in inFrontier
+        long long unexplored = 0;
+        for (auto &edges : adj) unexplored += (long long)edges.size();
+        unexplored -= (long long)adj[source].size();
+
+        bool bottomUp = false;
+        bool done = false;
+        int level = 0;
+        Barrier barrier(threads);
+
+        auto run = [&](int t) {
+            Local &me = local[t];
+            while (true) {
+                barrier.wait();
+                if (done) break;
+                me.next.clear();
+                me.edges = 0;
+
+                if (!bottomUp) {
+                    size_t lo = frontier.size() * t / threads;
+                    size_t hi = frontier.size() * (t + 1) / threads;
+                    for (size_t i = lo; i < hi; ++i) {
+                        int u = frontier[i];
+                        for (auto &[v, weight] : adj[u]) {
+                            if (parent[v].load(memory_order_relaxed) != -1) continue;
+                            int expected = -1;
+                            if (parent[v].compare_exchange_strong(expected, u, memory_order_relaxed)) {
+                                depth[v] = level + 1;
+                                me.next.push_back(v);
+                                me.edges += (long long)adj[v].size();
+                            }
+                        }
+                    }
+                } else {
+                    int lo = (int)((long long)n * t / threads);
+                    int hi = (int)((long long)n * (t + 1) / threads);
+                    for (int v = lo; v < hi; ++v) {
+                        if (parent[v].load(memory_order_relaxed) != -1) continue;
+                        for (auto &[u, weight] : adj[v]) {
+                            if (inFrontier[u]) {
+                                parent[v].store(u, memory_order_relaxed);
+                                depth[v] = level + 1;
+                                me.next.push_back(v);
+                                me.edges += (long long)adj[v].size();
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                barrier.wait();
+                if (t == 0) {
+                    frontier.clear();
+                    long long frontierEdges = 0;
+                    for (auto &l : local) {
+                        frontier.insert(frontier.end(), l.next.begin(), l.next.end());
+                        frontierEdges += l.edges;
+                    }
+                    unexplored -= frontierEdges;
+                    ++level;
+                    done = frontier.empty();
+
+                    if (!bottomUp && frontierEdges > unexplored / ALPHA)
+                        bottomUp = true;
+                    else if (bottomUp && (long long)frontier.size() < n / BETA)
+                        bottomUp = false;
+
+                    for (int u : marked) inFrontier[u] = 0;
+                    marked.clear();
+                    if (bottomUp) {
+                        for (int u : frontier) inFrontier[u] = 1;
+                        marked = frontier;
+                    }
+                }
+            }
+        };
+
+        vector<thread> pool;
+        for (int t = 1; t < threads; ++t) pool.emplace_back(run, t);
+        run(0);
+        for (auto &th : pool) th.join();
+
+        vector<int> par(n);
+        for (int v = 0; v < n; ++v) par[v] = parent[v].load(memory_order_relaxed);
+        return {depth, par};
+    }
+
+    static constexpr long long INF = numeric_limits<long long>::max();
+
+    // Dijkstra's single-source shortest paths (weights must be >= 0).
+    // Returns {dist, pred}: dist[v] = INF and pred[v] = -1 when v is unreachable.
+    // Uses a monotone radix heap instead of a binary heap: Dijkstra only ever
+    // pops non-decreasing distances, which is exactly what a radix heap needs.
+    pair<vector<long long>, vector<int>> dijkstra(int source) const {
+        vector<long long> dist(n, INF);
+        vector<int> pred(n, -1);
+        RadixHeap<int> heap;
+
+        dist[source] = 0;
+        heap.push(0, source);
+
+        while (!heap.empty()) {
+            auto [d, u] = heap.pop();
+            if ((long long)d != dist[u]) continue;  // stale entry
+
+            for (auto &[v, weight] : adj[u]) {
+                long long nd = (long long)d + weight;
+                if (nd < dist[v]) {
+                    dist[v] = nd;
+                    pred[v] = u;
+                    heap.push(nd, v);
+                }
+            }
+        }
+
+        return {dist, pred};
+    }
+
+    // Parallel delta-stepping SSSP (weights must be >= 0).
+    // Vertices are bucketed by floor(dist / delta). Each thread owns the vertices
+    // v with v % threads == t: it keeps their buckets, and it is the only writer
+    // of their dist/pred. Relaxations are sent as requests to the owner, so no
+    // locks or atomics are needed on the distance array; threads only meet at
+    // barriers between phases.
+    pair<vector<long long>, vector<int>> deltaStepping(int source, int delta = 0,
+                                                       int threads = 0) const {
+        if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+        if (delta <= 0) {
+            // Default: average edge weight (at least 1).
+            long long total = 0, m = 0;
+            for (auto &edges : adj)
+                for (auto &[v, weight] : edges) { total += weight; ++m; }
+            delta = (int)max(1LL, m ? total / m : 1);
+        }
+
+        vector<long long> dist(n, INF);
+        vector<int> pred(n, -1);
+
+        struct Request { int v; int parent; long long d; };
+        struct alignas(64) Worker {
+            vector<vector<int>> buckets;        // buckets of owned vertices
+            vector<int> settled;                // owned vertices removed from the current bucket
+            vector<vector<Request>> outbox;     // requests, indexed by owner thread
+        };
+        vector<Worker> workers(threads);
+        for (auto &w : workers) w.outbox.resize(threads);
+        vector<long long> settledIn(n, -1);     // bucket in which v was last settled
+
+        auto owner = [threads](int v) { return v % threads; };
+        auto push = [&](Worker &w, int v, long long d) {
+            size_t b = (size_t)(d / delta);
+            if (b >= w.buckets.size()) w.buckets.resize(b + 1);
+            w.buckets[b].push_back(v);
+        };
+
+        dist[source] = 0;
+        push(workers[owner(source)], source, 0);
+
+        Barrier barrier(threads);
+        long long current = 0;       // bucket being processed (written by thread 0)
+        bool bucketNonEmpty = false;
+        bool done = false;
+
+        auto generate = [&](Worker &w, const vector<int> &from, bool light) {
+            for (int u : from) {
+                for (auto &[v, weight] : adj[u]) {
+                    if ((weight <= delta) != light) continue;
+                    long long nd = dist[u] + weight;
+                    w.outbox[owner(v)].push_back({v, u, nd});
+                }
+            }
+        };
+        auto apply = [&](int t) {
+            for (auto &src : workers) {
+                for (auto &r : src.outbox[t]) {
+                    if (r.d < dist[r.v]) {
+                        dist[r.v] = r.d;
+                        pred[r.v] = r.parent;
+                        push(workers[t], r.v, r.d);
+                    }
+                }
+            }
+        };
+
+        auto run = [&](int t) {
+            Worker &me = workers[t];
+            vector<int> frontier;
+            while (true) {
+                // Thread 0 picks the smallest non-empty bucket across all owners.
+                barrier.wait();
+                if (t == 0) {
+                    long long best = -1;
+                    for (auto &w : workers)
+                        for (size_t b = current; b < w.buckets.size(); ++b)
+                            if (!w.buckets[b].empty()) {
+                                if (best < 0 || (long long)b < best) best = b;
+                                break;
+                            }
+                    done = best < 0;
+                    if (!done) current = best;
+                }
+                barrier.wait();
+                if (done) break;
+
+                // Light-edge phases: repeat until bucket `current` stays empty.
+                while (true) {
+                    frontier.clear();
+                    if ((size_t)current < me.buckets.size()) {
+                        for (int u : me.buckets[current]) {
+                            if (dist[u] / delta != current) continue;  // moved to a lower bucket
+                            frontier.push_back(u);
+                            if (settledIn[u] != current) {
+                                settledIn[u] = current;
+                                me.settled.push_back(u);
+                            }
+                        }
+                        me.buckets[current].clear();
+                    }
+                    generate(me, frontier, true);
+                    barrier.wait();
+                    apply(t);
+                    barrier.wait();
+                    for (auto &out : me.outbox) out.clear();
+                    if (t == 0) {
+                        bucketNonEmpty = false;
+                        for (auto &w : workers)
+                            if ((size_t)current < w.buckets.size() && !w.buckets[current].empty())
+                                bucketNonEmpty = true;
+                    }
+                    barrier.wait();
+                    if (!bucketNonEmpty) break;
+                }
+
+                // Heavy edges from every vertex settled in this bucket, once.
+                generate(me, me.settled, false);
+                me.settled.clear();
+                barrier.wait();
+                apply(t);
+                barrier.wait();
+                for (auto &out : me.outbox) out.clear();
+            }
+        };
+
+        vector<thread> pool;
+        for (int t = 1; t < threads; ++t) pool.emplace_back(run, t);
+        run(0);
+        for (auto &th : pool) th.join();
+
+        return {dist, pred};
+    }
 };
 
-int main() {
+// ================= Synthetic graphs and MST benchmark =================
+// Usage: ./MST bench <rmat|er|grid|rgg> [scale=16] [edgefactor=8] [seed=42] [threads=0]
+// n = 2^scale vertices, about edgefactor * n edges, weights uniform in [1, 255].
+// Prints one JSON object per line (stage, seconds, edges/s or points/s, the
+// stage's and the process's peak RSS) so runs can be diffed or loaded into a
+// regression tracker.
+
+// R-MAT (Chakrabarti et al.) with the Graph500 parameters a=.57, b=c=.19.
+Graph makeRMAT(int scale, long long m, mt19937_64 &rng) {
+    int n = 1 << scale;
+    Graph g(n);
+    uniform_real_distribution<double> U(0.0, 1.0);
+    uniform_int_distribution<int> W(1, 255);
+    for (long long e = 0; e < m; ++e) {
+        int u = 0, v = 0;
+        for (int bit = 0; bit < scale; ++bit) {
+            double r = U(rng);
+            if (r < 0.57) {}
+            else if (r < 0.76) v |= 1 << bit;
+            else if (r < 0.95) u |= 1 << bit;
+            else { u |= 1 << bit; v |= 1 << bit; }
+        }
+        if (u != v) g.addEdge(u, v, W(rng));
+    }
+    return g;
+}
+
+// Erdos-Renyi G(n, m): m edges with uniformly random endpoints.
+Graph makeErdosRenyi(int n, long long m, mt19937_64 &rng) {
+    Graph g(n);
+    uniform_int_distribution<int> V(0, n - 1);
+    uniform_int_distribution<int> W(1, 255);
+    for (long long e = 0; e < m; ++e) {
+        int u = V(rng), v = V(rng);
+        if (u != v) g.addEdge(u, v, W(rng));
+    }
+    return g;
+}
+
+// side x side 4-neighbour grid.
+Graph makeGrid(int side, mt19937_64 &rng) {
+    Graph g(side * side);
+    uniform_int_distribution<int> W(1, 255);
+    for (int r = 0; r < side; ++r)
+        for (int c = 0; c < side; ++c) {
+            int u = r * side + c;
+            if (c + 1 < side) g.addEdge(u, u + 1, W(rng));
+            if (r + 1 < side) g.addEdge(u, u + side, W(rng));
+        }
+    return g;
+}
+
+// Random geometric graph: n points in the unit square, an edge between
+// every pair closer than `radius` (weight proportional to distance).
+// Pairs are found by binning points into radius-sized cells.
+Graph makeRandomGeometric(int n, double radius, mt19937_64 &rng,
+                          vector<array<double, 2>> &pts) {
+    uniform_real_distribution<double> U(0.0, 1.0);
+    pts.resize(n);
+    for (auto &p : pts) p = {U(rng), U(rng)};
+
+    int cells = max(1, (int)(1.0 / radius));
+    vector<vector<int>> grid((size_t)cells * cells);
+    auto cellOf = [&](double x) { return min(cells - 1, (int)(x * cells)); };
+    for (int i = 0; i < n; ++i)
+        grid[(size_t)cellOf(pts[i][0]) * cells + cellOf(pts[i][1])].push_back(i);
+
+    Graph g(n);
+    double r2 = radius * radius;
+    for (int i = 0; i < n; ++i) {
+        int cx = cellOf(pts[i][0]), cy = cellOf(pts[i][1]);
+        for (int dx = -1; dx <= 1; ++dx)
+            for (int dy = -1; dy <= 1; ++dy) {
+                int x = cx + dx, y = cy + dy;
+                if (x < 0 || y < 0 || x >= cells || y >= cells) continue;
+                for (int j : grid[(size_t)x * cells + y]) {
+                    if (j <= i) continue;
+                    double d2 = KdTree<2>::dist2(pts[i], pts[j]);
+                    if (d2 < r2) g.addEdge(i, j, 1 + (int)(254 * sqrt(d2) / radius));
+                }
+            }
+    }
+    return g;
+}
+
+// High-water mark of the whole process so far; it never goes down.
+long processPeakRssKB() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;  // kilobytes on Linux
+}
+
+// Per-stage peak: on Linux, writing 5 to /proc/self/clear_refs resets the
+// VmHWM high-water mark to the current RSS, so VmHWM read after a stage is
+// that stage's own peak (memory it started with included). Returns false
+// where the reset is unavailable.
+bool resetPeakRss() {
+    ofstream clear("/proc/self/clear_refs");
+    clear << "5";
+    clear.flush();
+    return (bool)clear;
+}
+
+// VmHWM in kilobytes, or -1 if /proc/self/status has none.
+long peakRssSinceResetKB() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line))
+        if (line.rfind("VmHWM:", 0) == 0) return stol(line.substr(6));
+    return -1;
+}
+
+template <typename Func>
+double timeIt(Func func) {
+    auto start = chrono::steady_clock::now();
+    func();
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double>(end - start).count();
+}
+
+int runBenchmark(int argc, char **argv) {
+    string kind = argc > 2 ? argv[2] : "rmat";
+    int scale = argc > 3 ? stoi(argv[3]) : 16;
+    int edgefactor = argc > 4 ? stoi(argv[4]) : 8;
+    unsigned long long seed = argc > 5 ? stoull(argv[5]) : 42;
+    int threads = argc > 6 ? stoi(argv[6]) : 0;
+
+    mt19937_64 rng(seed);
+    int n = 1 << scale;
+    long long m = (long long)edgefactor * n;
+    vector<array<double, 2>> pts;
+    Graph g(0);
+
+    // Each stage is timed by timeStage(), which also resets the RSS
+    // high-water mark, so "stage_peak_rss_kb" is that stage's own peak
+    // (omitted where it cannot be measured). "process_peak_rss_kb" is the
+    // process-wide peak so far.
+    bool stagePeak = false;
+    auto timeStage = [&](auto func) {
+        stagePeak = resetPeakRss();
+        return timeIt(func);
+    };
+
+    // `unit` names what `items` counts: the rate is emitted as "<unit>_per_sec".
+    auto report = [&](const string &stage, double seconds, long long items, const string &unit,
+                      const string &extra) {
+        long stageKB = stagePeak ? peakRssSinceResetKB() : -1;
+        cout << "{\"graph\":\"" << kind << "\",\"scale\":" << scale
+             << ",\"edgefactor\":" << edgefactor << ",\"seed\":" << seed
+             << ",\"vertices\":" << g.numVertices() << ",\"edges\":" << g.numEdges()
+             << ",\"stage\":\"" << stage << "\",\"seconds\":" << seconds
+             << ",\"" << unit << "_per_sec\":" << (seconds > 0 ? items / seconds : 0);
+        if (stageKB >= 0) cout << ",\"stage_peak_rss_kb\":" << stageKB;
+        cout << ",\"process_peak_rss_kb\":" << processPeakRssKB() << extra << "}" << endl;
+    };
+
+    double t = timeStage([&] {
+        if (kind == "rmat") g = makeRMAT(scale, m, rng);
+        else if (kind == "er") g = makeErdosRenyi(n, m, rng);
+        else if (kind == "grid") g = makeGrid(1 << (scale / 2), rng);
+        else if (kind == "rgg") g = makeRandomGeometric(n, sqrt(edgefactor / (3.14159265 * n)), rng, pts);
+    });
+    if (g.numVertices() == 0) {
+        cerr << "unknown graph kind '" << kind << "' (rmat|er|grid|rgg)\n";
+        return 1;
+    }
+    report("construct", t, g.numEdges(), "edges", "");
+
+    // primMST spans only its start vertex's component, and ER/RGG graphs at
+    // low degree are disconnected: start it in the largest component and
+    // rate it by that component's edges.
+    vector<int> comp = g.connectedComponents(threads).second;
+    vector<int> compSize(g.numVertices(), 0);
+    for (int c : comp) ++compSize[c];
+    int start = (int)(max_element(compSize.begin(), compSize.end()) - compSize.begin());
+    long long startEdges = 0;
+    for (int v = 0; v < g.numVertices(); ++v)
+        if (comp[v] == start) startEdges += g.degree(v);
+    startEdges /= 2;
+
+    long long mstWeight = 0;
+    size_t mstEdges = 0;
+    t = timeStage([&] {
+        auto [w, edges] = g.primMST(start);
+        mstWeight = w;
+        mstEdges = edges.size();
+    });
+    report("primMST", t, startEdges, "edges",
+           ",\"component_vertices\":" + to_string(compSize[start]) + ",\"component_edges\":" +
+           to_string(startEdges) + ",\"mst_weight\":" + to_string(mstWeight) + ",\"mst_edges\":" +
+           to_string(mstEdges));
+
+    t = timeStage([&] {
+        DynamicMST d = g.dynamicMST();
+        mstWeight = d.mst_weight();
+        mstEdges = d.numEdges();
+    });
+    report("dynamicMST", t, g.numEdges(), "edges",
+           ",\"mst_weight\":" + to_string(mstWeight) + ",\"mst_edges\":" + to_string(mstEdges));
+
+    if (!pts.empty()) {
+        double length = 0;
+        t = timeStage([&] {
+            auto [len, edges] = euclideanMST<2>(pts);
+            length = len;
+            mstEdges = edges.size();
+        });
+        // Euclidean MST of the complete graph over the same points.
+        report("euclideanMST", t, (long long)pts.size(), "points",
+               ",\"mst_length\":" + to_string(length) + ",\"mst_edges\":" + to_string(mstEdges));
+    }
+
+    int components = 0;
+    t = timeStage([&] { components = g.connectedComponents(threads).first; });
+    report("connectedComponents", t, g.numEdges(), "edges", ",\"components\":" + to_string(components));
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && string(argv[1]) == "bench")
+        return runBenchmark(argc, argv);
+
     // ---- Create a graph manually here ----
     int n = 6;
     Graph g(n);
@@ -78,5 +1111,31 @@ int main() {
         cout << u << " - " << v << " (" << w << ")\n";
     }
 
+    auto [components, comp] = g.connectedComponents();
+    cout << "Connected: " << (components == 1 ? "yes" : "no")
+         << " (" << components << " component(s))\n";
+    auto [depth, parent] = g.bfs(0);
+    cout << "BFS depth of vertex 5 from 0 = " << depth[5] << "\n";
+
+    // Keep the MST up to date while new links arrive.
+    DynamicMST dyn = g.dynamicMST();
+    dyn.insertEdge(4, 5, 1);   // replaces 3 - 5 (3)
+    dyn.insertEdge(0, 5, 9);   // heavier than every edge on the cycle, ignored
+    cout << "Dynamic MST Weight after insertions = " << dyn.mst_weight() << "\n";
+
+    // Euclidean MST straight from coordinates (no edge list).
+    vector<array<double, 2>> pts = {{0, 0}, {1, 0}, {1, 1}, {4, 1}, {4, 3}, {0, 2}};
+    auto [len, geoEdges] = euclideanMST<2>(pts);
+    cout << "Euclidean MST length = " << len << " (" << geoEdges.size() << " edges)\n";
+
+    auto [dist, pred] = g.dijkstra(0);
+    auto [pdist, ppred] = g.deltaStepping(0, 2);
+    cout << "Shortest paths from 0:\n";
+    for (int v = 0; v < n; ++v) {
+        cout << v << ": dist " << dist[v] << " (pred " << pred[v] << ")";
+        if (pdist[v] != dist[v]) cout << "  [delta-stepping mismatch: " << pdist[v] << "]";
+        cout << "\n";
+    }
+
     return 0;
 }
@@ -1,10 +1,32 @@
 #include <iostream>
 #include <string>
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <string_view>
+#include <random>
+#include <cmath>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "set_hash.h"
+#include "table_stats.h"
 using namespace std;
 
 // ------------------ Hash Functor ------------------
 struct SimpleHash {
-    size_t operator()(const string& s) const {
+    size_t operator()(string_view s) const {
         size_t h = 0;
         for (char c : s)
             h = h * 131 + c;
@@ -12,103 +34,1502 @@ struct SimpleHash {
     }
 };
 
-// ------------------ Hash Table ------------------
-template<typename HashFunc>
-class HashTable {
+// ------------------ Word-at-a-time Hash Functors ------------------
+// SimpleHash folds in one byte per step, and every step waits on the
+// previous multiply. The functors below read 8 or 16 bytes per step and mix
+// with 64x64->128-bit multiplies. Both halves of the product are folded
+// back, so all output bits depend on all input bits. They take
+// string_view, so they also hash std::string and literals without copying.
+// They are drop-in HashFunc arguments: HashTable<WyHash>, HashTable<Xxh3Hash>.
+
+static inline uint64_t read64(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint64_t read32(const char* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// 1..3 bytes: first, middle and last byte.
+static inline uint64_t read1to3(const char* p, size_t n) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return ((uint64_t)u[0] << 16) | ((uint64_t)u[n >> 1] << 8) | u[n - 1];
+}
+
+static inline uint64_t mulFold64(uint64_t a, uint64_t b) {
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+// wyhash (final version) structure: inputs up to 16 bytes are read as two
+// possibly-overlapping words; longer ones are consumed 16 bytes per step,
+// in three independent chains once past 48 bytes.
+struct WyHash {
+    uint64_t seed = 0;
+
+    size_t operator()(string_view key) const {
+        static constexpr uint64_t S0 = 0x2d358dccaa6c78a5ULL, S1 = 0x8bb84b93962eacc9ULL,
+                                  S2 = 0x4b33a62ed433d4a3ULL, S3 = 0x4d5a2da51de1aa47ULL;
+        const char* p = key.data();
+        size_t n = key.size();
+        uint64_t h = seed ^ mulFold64(seed ^ S0, S1);
+        uint64_t a, b;
+
+        if (n <= 16) {
+            if (n >= 4) {
+                size_t mid = (n >> 3) << 2;
+                a = (read32(p) << 32) | read32(p + mid);
+                b = (read32(p + n - 4) << 32) | read32(p + n - 4 - mid);
+            } else if (n > 0) {
+                a = read1to3(p, n);
+                b = 0;
+            } else {
+                a = b = 0;
+            }
+        } else {
+            size_t i = n;
+            if (i > 48) {
+                uint64_t h1 = h, h2 = h;
+                do {
+                    h = mulFold64(read64(p) ^ S1, read64(p + 8) ^ h);
+                    h1 = mulFold64(read64(p + 16) ^ S2, read64(p + 24) ^ h1);
+                    h2 = mulFold64(read64(p + 32) ^ S3, read64(p + 40) ^ h2);
+                    p += 48;
+                    i -= 48;
+                } while (i > 48);
+                h ^= h1 ^ h2;
+            }
+            while (i > 16) {
+                h = mulFold64(read64(p) ^ S1, read64(p + 8) ^ h);
+                p += 16;
+                i -= 16;
+            }
+            a = read64(p + i - 16);
+            b = read64(p + i - 8);
+        }
+
+        __uint128_t r = (__uint128_t)(a ^ S1) * (b ^ h);
+        return mulFold64((uint64_t)r ^ S0 ^ n, (uint64_t)(r >> 64) ^ S1);
+    }
+};
+
+// xxh3 structure. Up to 16 bytes: one 128-bit multiply. 17..240 bytes:
+// independent 16-byte multiplies (they overlap in the pipeline instead of
+// chaining), each against its own secret words. Longer: 64-byte stripes
+// into eight 64-bit accumulators with 32x32->64 multiplies, which map
+// directly onto SSE2 (_mm_mul_epu32); the accumulators are scrambled every
+// 1 KB. UseSimd only selects the SSE2 loop -- both loops compute the same
+// value, so Xxh3Hash and Xxh3ScalarHash are interchangeable.
+template <bool UseSimd>
+struct Xxh3Style {
+    uint64_t seed = 0;
+
+    static constexpr uint64_t SECRET[32] = {
+        0x3a34ce6380fc0bc5ULL, 0xc05a677850dc981aULL, 0x9e32cdf7948370bdULL, 0xa7765f796f00bbefULL,
+        0xbbbb23fe6921fe52ULL, 0x5bf0c31cacf1e17fULL, 0x3e1900a6529be043ULL, 0x2a16cd9ed424ea1eULL,
+        0x579593114410e048ULL, 0x0a29f5fe3df351f0ULL, 0x1b4897e079059ad2ULL, 0x2d9cd179c9e412e1ULL,
+        0x315949173d12f7e0ULL, 0x7c69b356b72b606fULL, 0xb6ec11f8caa9ebcfULL, 0x841e03b1ed92f734ULL,
+        0x8898a5df2ba2ae99ULL, 0xf810fea09e7eeaa5ULL, 0x27a56de32b6a852cULL, 0x141d3cdeb2a328a7ULL,
+        0xfa6c784c6c59c00fULL, 0x6bb8c0b28140b75fULL, 0xb3469baeabcf5facULL, 0xc03b1af969a981b8ULL,
+        0xec7c99144be2ac06ULL, 0x52af400deb7b9daeULL, 0x4e3c54f2f51f1e28ULL, 0x7991820c21348daaULL,
+        0x16fda58f4606377cULL, 0x1f2b3b8ec35c9e73ULL, 0x88ba012f31187eb0ULL, 0x38156c76ce316da2ULL};
+    static constexpr size_t MID_MAX = 240;   // longest key hashed with independent 16-byte steps
+    static constexpr size_t STRIPE = 64;
+    static constexpr size_t BLOCK_STRIPES = 16;
+
+    static uint64_t avalanche(uint64_t h) {
+        h ^= h >> 37;
+        h *= 0x165667919E3779F9ULL;
+        return h ^ (h >> 32);
+    }
+
+    uint64_t mix16(const char* p, const uint64_t* s) const {
+        return mulFold64(read64(p) ^ (s[0] + seed), read64(p + 8) ^ (s[1] - seed));
+    }
+
+    static uint64_t mul32x32(uint64_t k) { return (k & 0xffffffffULL) * (k >> 32); }
+
+    // Words 2i and 2i+1 of a stripe: for each word d at position j,
+    // acc[j] += lo32(d ^ s) * hi32(d ^ s) and acc[j ^ 1] += d.
+    static void accumulatePair(uint64_t& even, uint64_t& odd, const char* q, const uint64_t* s) {
+        uint64_t d0 = read64(q), d1 = read64(q + 8);
+        even += mul32x32(d0 ^ s[0]) + d1;
+        odd += mul32x32(d1 ^ s[1]) + d0;
+    }
+
+    static void scrambleWord(uint64_t& a, uint64_t s) {
+        a ^= a >> 47;
+        a ^= s;
+        a *= 0x9E3779B1ULL;
+    }
+
+    // All stripes, including the last overlapping one at p + n - STRIPE.
+    // The eight accumulators are locals so they stay in registers.
+    static void stripesScalar(uint64_t* acc, const char* p, size_t n) {
+        uint64_t a0 = acc[0], a1 = acc[1], a2 = acc[2], a3 = acc[3];
+        uint64_t a4 = acc[4], a5 = acc[5], a6 = acc[6], a7 = acc[7];
+        auto stripe = [&](const char* q) {
+            accumulatePair(a0, a1, q, SECRET);
+            accumulatePair(a2, a3, q + 16, SECRET + 2);
+            accumulatePair(a4, a5, q + 32, SECRET + 4);
+            accumulatePair(a6, a7, q + 48, SECRET + 6);
+        };
+
+        size_t stripes = (n - 1) / STRIPE;
+        for (size_t done = 0; done < stripes; done += BLOCK_STRIPES) {
+            size_t end = min(done + BLOCK_STRIPES, stripes);
+            for (size_t st = done; st < end; ++st) stripe(p + st * STRIPE);
+            scrambleWord(a0, SECRET[8]);
+            scrambleWord(a1, SECRET[9]);
+            scrambleWord(a2, SECRET[10]);
+            scrambleWord(a3, SECRET[11]);
+            scrambleWord(a4, SECRET[12]);
+            scrambleWord(a5, SECRET[13]);
+            scrambleWord(a6, SECRET[14]);
+            scrambleWord(a7, SECRET[15]);
+        }
+        stripe(p + n - STRIPE);
+
+        acc[0] = a0, acc[1] = a1, acc[2] = a2, acc[3] = a3;
+        acc[4] = a4, acc[5] = a5, acc[6] = a6, acc[7] = a7;
+    }
+
+#ifdef __SSE2__
+    // Same computation, with the accumulators held in four SSE2 registers
+    // from start to end (the scramble's 64x32-bit multiply is two
+    // _mm_mul_epu32). Written out per register so none spills to memory.
+    static __m128i accumulateLane(__m128i acc, const char* q, __m128i key) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+        __m128i k = _mm_xor_si128(d, key);
+        __m128i prod = _mm_mul_epu32(k, _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1)));
+        __m128i swapped = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+        return _mm_add_epi64(acc, _mm_add_epi64(prod, swapped));
+    }
+
+    static __m128i scrambleLane(__m128i acc, __m128i key) {
+        const __m128i prime = _mm_set1_epi64x(0x9E3779B1);
+        __m128i x = _mm_xor_si128(_mm_xor_si128(acc, _mm_srli_epi64(acc, 47)), key);
+        __m128i lo = _mm_mul_epu32(x, prime);
+        __m128i hi = _mm_mul_epu32(_mm_srli_epi64(x, 32), prime);
+        return _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+    }
+
+    static void stripesSse2(uint64_t* acc, const char* p, size_t n) {
+        auto load = [](const uint64_t* w) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(w)); };
+        __m128i a0 = load(acc), a1 = load(acc + 2), a2 = load(acc + 4), a3 = load(acc + 6);
+        const __m128i k0 = load(SECRET), k1 = load(SECRET + 2), k2 = load(SECRET + 4), k3 = load(SECRET + 6);
+        auto stripe = [&](const char* q) {
+            a0 = accumulateLane(a0, q, k0);
+            a1 = accumulateLane(a1, q + 16, k1);
+            a2 = accumulateLane(a2, q + 32, k2);
+            a3 = accumulateLane(a3, q + 48, k3);
+        };
+
+        size_t stripes = (n - 1) / STRIPE;
+        for (size_t done = 0; done < stripes; done += BLOCK_STRIPES) {
+            size_t end = min(done + BLOCK_STRIPES, stripes);
+            for (size_t st = done; st < end; ++st) stripe(p + st * STRIPE);
+            a0 = scrambleLane(a0, load(SECRET + 8));
+            a1 = scrambleLane(a1, load(SECRET + 10));
+            a2 = scrambleLane(a2, load(SECRET + 12));
+            a3 = scrambleLane(a3, load(SECRET + 14));
+        }
+        stripe(p + n - STRIPE);
+
+        __m128i* out = reinterpret_cast<__m128i*>(acc);
+        _mm_storeu_si128(out, a0);
+        _mm_storeu_si128(out + 1, a1);
+        _mm_storeu_si128(out + 2, a2);
+        _mm_storeu_si128(out + 3, a3);
+    }
+#endif
+
+    size_t operator()(string_view key) const {
+        const char* p = key.data();
+        size_t n = key.size();
+
+        if (n <= 16) {
+            uint64_t a, b;
+            if (n >= 8) {
+                a = read64(p);
+                b = read64(p + n - 8);
+            } else if (n >= 4) {
+                a = read32(p);
+                b = read32(p + n - 4);
+            } else {
+                a = n ? read1to3(p, n) : 0;
+                b = 0;
+            }
+            return avalanche(mulFold64(a ^ (SECRET[0] + seed), b ^ (SECRET[1] - seed)) ^ n);
+        }
+
+        uint64_t h = n * 0x9E3779B185EBCA87ULL;
+        if (n <= MID_MAX) {
+            size_t i = 0;
+            for (; i + 16 < n; i += 16)
+                h += mix16(p + i, SECRET + i / 8);
+            h += mix16(p + n - 16, SECRET + 30);
+            return avalanche(h);
+        }
+
+        return hashLong(p, n, h);
+    }
+
 private:
-    static const int SIZE = 10;
+    // Kept out of operator() so the short-key paths stay small enough to inline.
+    uint64_t hashLong(const char* p, size_t n, uint64_t h) const {
+        uint64_t acc[8] = {0xC2B2AE3DULL, 0x9E3779B185EBCA87ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL,
+                           0x85EBCA77C2B2AE63ULL, 0x85EBCA77ULL, 0x27D4EB2F165667C5ULL, 0x9E3779B1ULL};
+        acc[0] += seed;
+#ifdef __SSE2__
+        if constexpr (UseSimd)
+            stripesSse2(acc, p, n);
+        else
+#endif
+            stripesScalar(acc, p, n);
+        for (int j = 0; j < 8; j += 2)
+            h += mulFold64(acc[j] ^ SECRET[16 + j], acc[j + 1] ^ SECRET[17 + j]);
+        return avalanche(h);
+    }
+};
 
-    string table[SIZE];
-    bool used[SIZE] = { false };     // true = slot has ever been used
-    bool deleted[SIZE] = { false };  // true = slot was used then deleted
+using Xxh3Hash = Xxh3Style<true>;
+using Xxh3ScalarHash = Xxh3Style<false>;
+
+// ------------------ Compile-time Perfect Hashing ------------------
+// For a key set fixed at compile time (command names, header fields), build
+// a collision-free table with hash-and-displace (the CHD idea):
+//   - one seeded 64-bit hash h per key; its top bits pick a bucket;
+//   - every bucket gets a displacement d, chosen (largest buckets first) so
+//     that slot = (lo32(h) + d * (hi32(h) | 1)) & (SLOTS - 1) is free for
+//     all keys of the bucket;
+//   - if some bucket cannot be placed, start again with the next seed.
+// A lookup is one hash, one displacement read and one compare. build()
+// is constexpr, so the table is a constant in the binary, and a failure
+// (e.g. a duplicate key) is a compile error. The hash is byte-at-a-time
+// because constexpr code cannot memcpy words; keywords are short.
+constexpr uint64_t perfectHashBase(string_view s, uint64_t seed) {
+    uint64_t h = (seed * 0x9E3779B97F4A7C15ULL) ^ s.size();
+    for (char c : s)
+        h = (h ^ (unsigned char)c) * 0x100000001b3ULL;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    return h ^ (h >> 33);
+}
+
+constexpr size_t ceilPow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p *= 2;
+    return p;
+}
+
+template <size_t N>
+class PerfectHash {
+public:
+    static constexpr size_t SLOTS = ceilPow2(N + N / 4 + 1);   // load <= 0.8
+    static constexpr size_t BUCKETS = ceilPow2(N / 2 + 1);     // ~2 keys per bucket
+
+private:
+    static constexpr int BUCKET_BITS = __builtin_ctzll(BUCKETS);
+    static constexpr uint32_t MAX_DISPLACEMENT = 4 * SLOTS;
+    static constexpr uint64_t MAX_SEED = 64;
+
+    uint64_t seed = 0;
+    uint32_t displacement[BUCKETS] = {};
+    string_view keys[SLOTS] = {};
+    bool used[SLOTS] = {};
+
+    static constexpr size_t bucketOf(uint64_t h) { return BUCKET_BITS ? h >> (64 - BUCKET_BITS) : 0; }
+
+    static constexpr size_t slotOf(uint64_t h, uint32_t d) {
+        return ((uint32_t)h + (uint64_t)d * ((h >> 32) | 1)) & (SLOTS - 1);
+    }
+
+    // Place every bucket for this seed, largest first; false if one cannot be placed.
+    constexpr bool place(const string_view (&input)[N]) {
+        uint64_t h[N] = {};
+        size_t start[BUCKETS + 1] = {};   // keys of bucket b: order[start[b] .. start[b + 1])
+        size_t order[N] = {};
+        for (size_t i = 0; i < N; i++) {
+            h[i] = perfectHashBase(input[i], seed);
+            start[bucketOf(h[i]) + 1]++;
+        }
+        for (size_t b = 0; b < BUCKETS; b++)
+            start[b + 1] += start[b];
+        size_t fill[BUCKETS] = {};
+        for (size_t i = 0; i < N; i++) {
+            size_t b = bucketOf(h[i]);
+            order[start[b] + fill[b]++] = i;
+        }
+
+        for (size_t size = N; size >= 1; size--) {
+            for (size_t b = 0; b < BUCKETS; b++) {
+                if (start[b + 1] - start[b] != size)
+                    continue;
+                bool placed = false;
+                for (uint32_t d = 0; d < MAX_DISPLACEMENT && !placed; d++) {
+                    // Claim slots key by key; on a clash, release this bucket's claims.
+                    size_t k = start[b];
+                    for (; k < start[b + 1]; k++) {
+                        size_t s = slotOf(h[order[k]], d);
+                        if (used[s])
+                            break;
+                        used[s] = true;
+                        keys[s] = input[order[k]];
+                    }
+                    placed = k == start[b + 1];
+                    if (placed)
+                        displacement[b] = d;
+                    else
+                        while (k-- > start[b])
+                            used[slotOf(h[order[k]], d)] = false;
+                }
+                if (!placed)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    static constexpr PerfectHash build(const string_view (&input)[N]) {
+        for (size_t i = 0; i < N; i++)
+            for (size_t j = i + 1; j < N; j++)
+                if (input[i] == input[j])
+                    throw "PerfectHash: duplicate key";   // reaching this is a compile error
+        for (uint64_t seed = 1; seed <= MAX_SEED; seed++) {
+            PerfectHash table;
+            table.seed = seed;
+            if (table.place(input))
+                return table;
+        }
+        throw "PerfectHash: no seed worked";
+    }
+
+    // Slot of s; for a member key this is the key's own slot.
+    constexpr size_t slot(string_view s) const {
+        uint64_t h = perfectHashBase(s, seed);
+        return slotOf(h, displacement[bucketOf(h)]);
+    }
+
+    constexpr bool contains(string_view s) const {
+        size_t i = slot(s);
+        return used[i] && keys[i] == s;
+    }
+
+    constexpr string_view key_at(size_t i) const { return keys[i]; }
+};
+
+// HashFunc adapter for a PerfectHash constant: HashTable<PerfectHashFunc<table>>
+// sized for SLOTS (or larger -- slots are < SLOTS, so growth keeps them
+// apart) stores every member key in its home slot, with no probing.
+template <const auto& Table>
+struct PerfectHashFunc {
+    size_t operator()(string_view s) const { return Table.slot(s); }
+};
+
+// ------------------ Stats Policies ------------------
+// Second template parameter of HashTable and ArenaHashTable: NoStats (the
+// default) or ProbeStats, from table_stats.h, shared with unordered_set_buggy.cpp.
+
+// ------------------ Probe Policies ------------------
+// Third template parameter of HashTable: the order in which slots are
+// visited after the home slot (hash & mask). A policy is a small cursor built
+// from the full hash and the mask. index() is the current slot and next()
+// steps to the following one. Every policy visits each slot of a power-of-two
+// table exactly once per cycle, so a walk always reaches an EMPTY slot.
+//
+// LinearProbe     h, h+1, h+2, ...       cache-friendly, but clusters build up
+// QuadraticProbe  h, h+1, h+3, h+6, ...  triangular offsets break up clusters
+// DoubleHashProbe h, h+s, h+2s, ...      odd step s from the upper hash bits,
+//                                        so keys sharing a home slot diverge
+struct LinearProbe {
+    size_t idx, mask;
+    LinearProbe(uint64_t h, size_t mask) : idx(h & mask), mask(mask) {}
+    size_t index() const { return idx; }
+    void next() { idx = (idx + 1) & mask; }
+};
+
+struct QuadraticProbe {
+    size_t idx, mask, step = 0;
+    QuadraticProbe(uint64_t h, size_t mask) : idx(h & mask), mask(mask) {}
+    size_t index() const { return idx; }
+    void next() { idx = (idx + ++step) & mask; }
+};
+
+struct DoubleHashProbe {
+    size_t idx, mask, step;
+    // The Fibonacci multiply spreads every hash bit into the top 32, so the
+    // step differs even for weak hashes whose high bits are all zero.
+    DoubleHashProbe(uint64_t h, size_t mask)
+        : idx(h & mask), mask(mask), step(((h * 0x9E3779B97F4A7C15ULL) >> 32) | 1) {}
+    size_t index() const { return idx; }
+    void next() { idx = (idx + step) & mask; }
+};
+
+// ------------------ Slot Table ------------------
+// Bookkeeping shared by HashTable and ArenaHashTable: one state byte per
+// slot, the key and tombstone counts, the growth policy over them, and the
+// table-shape half of stats_json(). Each table keeps its own slot payload
+// and rehashSlots(). The policy: grow by doubling once
+// (keys + tombstones) / capacity would exceed max_load. Tombstones count
+// because they lengthen probes just like keys. When most of that load is
+// tombstones, the table is rebuilt at the same capacity instead.
+class SlotTable {
+protected:
+    enum SlotState : unsigned char { EMPTY, OCCUPIED, DELETED };
+
+    vector<SlotState> state;
+    size_t size_ = 0;          // OCCUPIED slots
+    size_t tombstones = 0;     // DELETED slots
+    double max_load;
+
+    SlotTable(size_t capacity, double max_load)
+        : state(roundUpPow2(max<size_t>(capacity, 2)), EMPTY),
+          max_load(min(max(max_load, 0.1), 0.95)) {}
+
+    static size_t roundUpPow2(size_t n) {
+        size_t cap = 1;
+        while (cap < n) cap *= 2;
+        return cap;
+    }
+
+    // Capacity to rehash to before one more key goes in, or 0 if it already
+    // fits. After that rehash at least one slot is EMPTY.
+    size_t growTarget() const {
+        if (size_ + tombstones + 1 <= state.size() * max_load)
+            return 0;
+        size_t cap = state.size();
+        if (size_ + 1 > cap * max_load / 2)
+            cap *= 2;                  // mostly keys: grow
+        return cap;                    // mostly tombstones: just sweep them
+    }
+
+    // Capacity at which n keys fit without crossing max_load, or 0 if the
+    // current one does.
+    size_t reserveTarget(size_t n) const {
+        size_t cap = state.size();
+        while (n + tombstones > cap * max_load) cap *= 2;
+        return cap != state.size() ? cap : 0;
+    }
+
+    // Run rehashSlots(), timed only when the Stats policy records rehashes.
+    template <typename Stats, typename Rehash>
+    static void timedRehash(Stats& stats, Rehash rehashSlots) {
+        if constexpr (Stats::enabled) {
+            auto start = chrono::steady_clock::now();
+            rehashSlots();
+            stats.record_rehash(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        } else {
+            rehashSlots();
+        }
+    }
+
+    // Start a rebuild at new_cap: all slots EMPTY, no tombstones. Returns
+    // the old states for the caller to walk.
+    vector<SlotState> resetStates(size_t new_cap) {
+        vector<SlotState> old_state(new_cap, EMPTY);
+        state.swap(old_state);
+        tombstones = 0;
+        return old_state;
+    }
+
+    // Opening fields of stats_json(), from a scan of the slot states; the
+    // caller adds its own fields, the Stats counters and the closing brace.
+    // tombstone_ratio = deleted slots / capacity; max_cluster = longest run
+    // of non-EMPTY slots, which bounds the probe length of any miss under
+    // LinearProbe (the other policies jump out of a run).
+    string shapeJson() const {
+        size_t cap = state.size(), longest = 0, run = 0;
+        for (size_t i = 0; i < 2 * cap; i++) {   // twice round, so a cluster that wraps is measured whole
+            run = state[i % cap] != EMPTY ? min(run + 1, cap) : 0;
+            longest = max(longest, run);
+        }
+        string out = "{\"size\":" + to_string(size_);
+        out += ",\"capacity\":" + to_string(cap);
+        out += ",\"load_factor\":" + to_string(load_factor());
+        out += ",\"tombstones\":" + to_string(tombstones);
+        out += ",\"tombstone_ratio\":" + to_string((double)tombstones / cap);
+        out += ",\"max_cluster\":" + to_string(longest);
+        return out;
+    }
+
+public:
+    size_t size() const { return size_; }
+
+    size_t capacity() const { return state.size(); }
+
+    double load_factor() const { return (double)size_ / state.size(); }
+};
+
+// ------------------ Hash Table ------------------
+// Open addressing over a power-of-two array of slots, grown as described
+// under SlotTable. The home slot is hash & (capacity - 1), and the Probe
+// policy (linear by default) picks the slots visited after it.
+template<typename HashFunc, typename Stats = NoStats, typename Probe = LinearProbe>
+class HashTable : public SlotTable {
+private:
+    vector<string> table;
 
     HashFunc hash;
+    [[no_unique_address]] mutable Stats stats_;      // find() is const but still counted
+
+    Probe probe(uint64_t h) const { return Probe(h, table.size() - 1); }
+
+    void growIfNeeded() {
+        if (size_t cap = growTarget())
+            rehash(cap);
+    }
+
+    void rehash(size_t new_cap) { timedRehash(stats_, [&] { rehashSlots(new_cap); }); }
+
+    void rehashSlots(size_t new_cap) {
+        vector<string> old_table(new_cap);
+        table.swap(old_table);
+        vector<SlotState> old_state = resetStates(new_cap);
+
+        // Keys are distinct, so each one goes to the first EMPTY slot of its probe.
+        for (size_t i = 0; i < old_table.size(); i++) {
+            if (old_state[i] != OCCUPIED)
+                continue;
+            Probe p = probe(hash(old_table[i]));
+            while (state[p.index()] != EMPTY)
+                p.next();
+            table[p.index()] = std::move(old_table[i]);
+            state[p.index()] = OCCUPIED;
+        }
+    }
 
 public:
+    explicit HashTable(size_t capacity = 16, double max_load = 0.7)
+        : SlotTable(capacity, max_load), table(state.size()) {}
+
     // ------------------ INSERT ------------------
-    void insert(const string& key) {
-        size_t h = hash(key) % SIZE;
-
-        for (int i = 0; i < SIZE; i++) {
-            int idx = (h + i) % SIZE;
-
-            if (!used[idx] || deleted[idx]) {
-                table[idx] = key;
-                used[idx] = true;
-                deleted[idx] = false;
-                cout << "Inserted \"" << key << "\" at index " << idx << endl;
-                return;
-            }
+    // Returns false if the key was already present. The key goes into the
+    // first tombstone on its probe path, but only after the walk reaches an
+    // EMPTY slot without finding it, so a reused tombstone never creates a
+    // duplicate further down the chain.
+    bool insert(string_view key) { return insert(key, hash(key)); }
+
+    // The overloads taking h skip hashing: h must be hash(key), already
+    // computed by the caller (ShardedHashTable picks the shard with it).
+    bool insert(string_view key, uint64_t h) {
+        growIfNeeded();
+        Probe p = probe(h);
+        size_t target = table.size();   // first tombstone seen, if any
+
+        for (size_t idx; state[idx = p.index()] != EMPTY; p.next()) {
+            if (state[idx] == OCCUPIED && table[idx] == key)
+                return false;
+            if (state[idx] == DELETED && target == table.size())
+                target = idx;
         }
 
-        cout << "Table full! Cannot insert \"" << key << "\"\n";
+        if (target == table.size())
+            target = p.index();
+        else
+            tombstones--;
+        table[target] = key;
+        state[target] = OCCUPIED;
+        size_++;
+        return true;
     }
 
     // ------------------ FIND ------------------
-    void find(const string& key) {
-        size_t h = hash(key) % SIZE;
+    bool find(string_view key) const { return find(key, hash(key)); }
 
-        for (int i = 0; i < SIZE; i++) {
-            int idx = (h + i) % SIZE;
+    bool find(string_view key, uint64_t h) const {
+        Probe p = probe(h);
 
-            if (!used[idx] && !deleted[idx]) {
+        for (size_t i = 0;; i++, p.next()) {
+            size_t idx = p.index();
+            if (state[idx] == EMPTY) {
                 // Slot has never been used → cannot be further in probe chain
-                cout << key << " not found\n";
-                return;
+                stats_.record_miss(i);
+                return false;
             }
 
-            if (!deleted[idx] && table[idx] == key) {
-                cout << key << " found at index " << idx << endl;
-                return;
+            if (state[idx] == OCCUPIED && table[idx] == key) {
+                stats_.record_hit(i);
+                return true;
             }
         }
-
-        cout << key << " not found\n";
     }
 
     // ------------------ REMOVE ------------------
-    void remove(const string& key) {
-        size_t h = hash(key) % SIZE;
+    // Returns false if the key was not present.
+    bool remove(string_view key) { return remove(key, hash(key)); }
+
+    bool remove(string_view key, uint64_t h) {
+        for (Probe p = probe(h); state[p.index()] != EMPTY; p.next()) {
+            size_t idx = p.index();
+            if (state[idx] == OCCUPIED && table[idx] == key) {
+                // Mark as deleted (tombstone) and free the string now
+                state[idx] = DELETED;
+                table[idx] = string();
+                size_--;
+                tombstones++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Grow now so that n keys fit without crossing max_load.
+    void reserve(size_t n) {
+        if (size_t cap = reserveTarget(n))
+            rehash(cap);
+    }
+
+    template <typename Func>
+    void for_each(Func f) const {
+        for (size_t i = 0; i < table.size(); i++)
+            if (state[i] == OCCUPIED)
+                f(string_view(table[i]));
+    }
+
+    // ------------------ STATISTICS ------------------
+    const Stats& stats() const { return stats_; }
+
+    void reset_stats() { stats_.reset(); }
+
+    // One-line JSON: table shape (see SlotTable::shapeJson), then the Stats counters.
+    string stats_json() const {
+        string out = shapeJson();
+        stats_.append_json(out);
+        return out + "}";
+    }
+};
+
+// ------------------ Arena Hash Table ------------------
+// Same probing and growth policy as HashTable, but no std::string per slot.
+// Key bytes are appended to one contiguous arena, and a slot holds the
+// key's offset and length plus its full cached hash. Slot states stay in a
+// separate byte array as in HashTable, so a miss usually reads only that
+// array. So:
+//   - inserting a key never allocates on its own (the arena grows by 1.5x);
+//   - a probe compares the cached hash first and touches key bytes only on
+//     a full 64-bit match, i.e. almost only for the key it is looking for;
+//   - rehash moves 24-byte slots by their cached hash and never rehashes or
+//     copies key bytes.
+// Removed keys leave dead bytes in the arena; remove() compacts the arena
+// as soon as half of it is dead. Views passed to for_each() point into the
+// arena, so they are valid only until the next insert or remove; insert()
+// itself may be handed one.
+template<typename HashFunc, typename Stats = NoStats>
+class ArenaHashTable : public SlotTable {
+private:
+    struct Slot {
+        uint64_t hash;
+        uint64_t offset;       // into arena
+        uint64_t length;
+    };
 
-        for (int i = 0; i < SIZE; i++) {
-            int idx = (h + i) % SIZE;
+    // Below this many dead bytes a compaction would cost more slot scanning
+    // than the memory it gives back.
+    static constexpr size_t COMPACT_MIN_BYTES = 4096;
 
-            if (!used[idx] && !deleted[idx]) {
-                // Never used -> cannot be further
-                cout << "Cannot remove \"" << key << "\" (not found)\n";
-                return;
+    vector<Slot> table;
+    vector<char> arena;
+    size_t dead_bytes = 0;     // arena bytes of removed keys
+
+    HashFunc hash;
+    [[no_unique_address]] mutable Stats stats_;      // find() is const but still counted
+
+    string_view keyOf(const Slot& slot) const { return string_view(arena.data() + slot.offset, slot.length); }
+
+    bool matches(const Slot& slot, string_view key, uint64_t h) const {
+        return slot.hash == h && slot.length == key.size() &&
+               memcmp(arena.data() + slot.offset, key.data(), key.size()) == 0;
+    }
+
+    void growIfNeeded() {
+        if (size_t cap = growTarget())
+            rehash(cap);
+    }
+
+    void rehash(size_t new_cap) { timedRehash(stats_, [&] { rehashSlots(new_cap); }); }
+
+    // Append key bytes, growing the arena by 1.5x rather than vector's 2x.
+    // The key may be a view into the arena itself (a for_each() key or part
+    // of one); growing moves those bytes, so it is re-pointed by offset.
+    uint64_t append(string_view key) {
+        uintptr_t base = (uintptr_t)arena.data(), at = (uintptr_t)key.data();
+        bool inside = !arena.empty() && at >= base && at < base + arena.size();
+        if (arena.size() + key.size() > arena.capacity()) {
+            arena.reserve(max(arena.size() + key.size(), arena.capacity() + arena.capacity() / 2));
+            if (inside) key = string_view(arena.data() + (at - base), key.size());
+        }
+        uint64_t offset = arena.size();
+        arena.insert(arena.end(), key.begin(), key.end());
+        return offset;
+    }
+
+    void rehashSlots(size_t new_cap) {
+        vector<Slot> old_table(new_cap);
+        table.swap(old_table);
+        vector<SlotState> old_state = resetStates(new_cap);
+
+        for (size_t i = 0; i < old_table.size(); i++) {
+            if (old_state[i] != OCCUPIED)
+                continue;
+            const Slot& slot = old_table[i];
+            size_t idx = slot.hash & (table.size() - 1);
+            while (state[idx] != EMPTY)
+                idx = (idx + 1) & (table.size() - 1);
+            table[idx] = slot;
+            state[idx] = OCCUPIED;
+        }
+    }
+
+    // Copy the live keys into a new arena sized to fit them exactly.
+    void compact() {
+        vector<char> old_arena;
+        old_arena.swap(arena);
+        arena.reserve(old_arena.size() - dead_bytes);
+        for (size_t i = 0; i < table.size(); i++) {
+            if (state[i] != OCCUPIED)
+                continue;
+            Slot& slot = table[i];
+            uint64_t offset = arena.size();
+            arena.insert(arena.end(), old_arena.begin() + slot.offset,
+                         old_arena.begin() + slot.offset + slot.length);
+            slot.offset = offset;
+        }
+        dead_bytes = 0;
+    }
+
+public:
+    explicit ArenaHashTable(size_t capacity = 16, double max_load = 0.7)
+        : SlotTable(capacity, max_load), table(state.size()) {}
+
+    // ------------------ INSERT ------------------
+    // Returns false if the key was already present.
+    bool insert(string_view key) {
+        growIfNeeded();
+        uint64_t h = hash(key);
+        size_t idx = h & (table.size() - 1);
+        size_t target = table.size();   // first tombstone seen, if any
+
+        while (state[idx] != EMPTY) {
+            if (state[idx] == OCCUPIED && matches(table[idx], key, h))
+                return false;
+            if (state[idx] == DELETED && target == table.size())
+                target = idx;
+            idx = (idx + 1) & (table.size() - 1);
+        }
+
+        if (target == table.size())
+            target = idx;
+        else
+            tombstones--;
+        table[target] = Slot{h, append(key), key.size()};
+        state[target] = OCCUPIED;
+        size_++;
+        return true;
+    }
+
+    // ------------------ FIND ------------------
+    bool find(string_view key) const {
+        uint64_t h = hash(key);
+        size_t idx = h & (table.size() - 1);
+
+        for (size_t i = 0;; i++) {
+            if (state[idx] == EMPTY) {
+                stats_.record_miss(i);
+                return false;
+            }
+            if (state[idx] == OCCUPIED && matches(table[idx], key, h)) {
+                stats_.record_hit(i);
+                return true;
             }
+            idx = (idx + 1) & (table.size() - 1);
+        }
+    }
 
-            if (!deleted[idx] && table[idx] == key) {
-                // Mark as deleted (tombstone)
-                deleted[idx] = true;
-                cout << "Removed \"" << key << "\" from index " << idx << endl;
-                return;
+    // ------------------ REMOVE ------------------
+    // Returns false if the key was not present.
+    bool remove(string_view key) {
+        uint64_t h = hash(key);
+        size_t idx = h & (table.size() - 1);
+
+        while (state[idx] != EMPTY) {
+            if (state[idx] == OCCUPIED && matches(table[idx], key, h)) {
+                state[idx] = DELETED;
+                dead_bytes += table[idx].length;
+                size_--;
+                tombstones++;
+                if (dead_bytes >= COMPACT_MIN_BYTES && dead_bytes * 2 >= arena.size())
+                    compact();
+                return true;
             }
+            idx = (idx + 1) & (table.size() - 1);
         }
+        return false;
+    }
+
+    // Grow now so that n keys (and about `bytes` of key data) fit without reallocating.
+    void reserve(size_t n, size_t bytes = 0) {
+        if (size_t cap = reserveTarget(n))
+            rehash(cap);
+        arena.reserve(bytes);
+    }
 
-        cout << "Cannot remove \"" << key << "\" (not found)\n";
+    template <typename Func>
+    void for_each(Func f) const {
+        for (size_t i = 0; i < table.size(); i++)
+            if (state[i] == OCCUPIED)
+                f(keyOf(table[i]));
+    }
+
+    // Slots plus the arena's allocation; there is nothing else on the heap.
+    size_t memory_bytes() const { return table.size() * (sizeof(Slot) + 1) + arena.capacity(); }
+
+    size_t arena_bytes() const { return arena.size(); }
+
+    // ------------------ STATISTICS ------------------
+    const Stats& stats() const { return stats_; }
+
+    void reset_stats() { stats_.reset(); }
+
+    string stats_json() const {
+        string out = shapeJson();
+        out += ",\"arena_bytes\":" + to_string(arena.size());
+        out += ",\"dead_bytes\":" + to_string(dead_bytes);
+        stats_.append_json(out);
+        return out + "}";
     }
 };
-int main() {
+
+// ------------------ Sharded Hash Table ------------------
+// HashTable for many writer threads: keys are routed to one of N shards
+// (a power of two), each a HashTable behind its own mutex, so threads only
+// contend when they hit the same shard. The shard is chosen from the top
+// bits of hash * 2^64/phi (Fibonacci hashing), which depend on every bit of
+// the hash -- SimpleHash's own top bits are zero for short keys -- and are
+// independent of the low bits the shard's table indexes with. The key is
+// hashed once: the shard's table is handed the same hash. Each shard
+// is aligned and padded to a cache line, so one shard's lock traffic never
+// invalidates its neighbours'.
+//
+// size() and for_each() lock every shard, always in index order, before
+// reading any of them, so they see one consistent snapshot: no insert or
+// remove is half-visible. for_each must not call back into the table.
+template<typename HashFunc>
+class ShardedHashTable {
+private:
+    struct alignas(64) Shard {
+        mutable mutex lock;
+        HashTable<HashFunc> table;
+    };
+
+    unique_ptr<Shard[]> shards;
+    size_t shard_count_;
+    int shift;                 // 64 - log2(shard_count_)
+    HashFunc hash;
+
+    Shard& shardOf(uint64_t h) const {
+        h *= 0x9E3779B97F4A7C15ULL;
+        return shards[shift == 64 ? 0 : h >> shift];
+    }
+
+    template <typename Func>
+    void withAllLocked(Func f) const {
+        struct UnlockAll {
+            const ShardedHashTable* owner;
+            ~UnlockAll() {
+                for (size_t i = owner->shard_count_; i-- > 0;) owner->shards[i].lock.unlock();
+            }
+        };
+        for (size_t i = 0; i < shard_count_; i++) shards[i].lock.lock();
+        UnlockAll unlock{this};
+        f();
+    }
+
+public:
+    explicit ShardedHashTable(size_t shard_count = 64)
+        : shards(new Shard[ceilPow2(max<size_t>(shard_count, 1))]),
+          shard_count_(ceilPow2(max<size_t>(shard_count, 1))), shift(64) {
+        while ((size_t(1) << (64 - shift)) < shard_count_) shift--;
+    }
+
+    bool insert(string_view key) {
+        uint64_t h = hash(key);
+        Shard& s = shardOf(h);
+        lock_guard<mutex> guard(s.lock);
+        return s.table.insert(key, h);
+    }
+
+    bool find(string_view key) const {
+        uint64_t h = hash(key);
+        Shard& s = shardOf(h);
+        lock_guard<mutex> guard(s.lock);
+        return s.table.find(key, h);
+    }
+
+    bool remove(string_view key) {
+        uint64_t h = hash(key);
+        Shard& s = shardOf(h);
+        lock_guard<mutex> guard(s.lock);
+        return s.table.remove(key, h);
+    }
+
+    // Presize every shard for an even share of n keys.
+    void reserve(size_t n) {
+        withAllLocked([&] {
+            for (size_t i = 0; i < shard_count_; i++) shards[i].table.reserve(n / shard_count_ + 1);
+        });
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        withAllLocked([&] {
+            for (size_t i = 0; i < shard_count_; i++) total += shards[i].table.size();
+        });
+        return total;
+    }
+
+    template <typename Func>
+    void for_each(Func f) const {
+        withAllLocked([&] {
+            for (size_t i = 0; i < shard_count_; i++) shards[i].table.for_each(f);
+        });
+    }
+
+    size_t shard_count() const { return shard_count_; }
+};
+
+// ------------------ Hash Benchmark ------------------
+// Usage: ./functor_hash hashbench [keys=1000000]
+//   throughput: ns per key and GB/s hashing cache-resident keys of fixed length;
+//   report:     each functor on each key corpus, one row per pair.
+//               hashReport<F> takes any HashFunc, so trying a new one is one line.
+//     B/cycle      bytes hashed per time-stamp-counter tick (per ns off x86)
+//     aval         mean share of output bits flipped by a one-bit input change (ideal 0.5)
+//     bias         worst |2p - 1| over (input bit, output bit) pairs, p = flip rate;
+//                  ~0.2 is sampling noise, 1.0 means an output bit ignores an input bit
+//     spread       keys into as many buckets, by the low bits as the tables use
+//                  them: sum of squared bucket loads over its expectation for a
+//                  random hash (1.0 ideal, above it clusters) and the largest bucket
+//     coll64       full 64-bit collisions
+//     table/set    mean probes per hit and per miss with linear probing at
+//                  HashTable's growth threshold (load 0.7) and at HashSet's (0.6);
+//                  string keys go through HashTable itself
+//   Integer corpora are hashed as integers by HashSet's own functors from
+//   set_hash.h, and probed the way HashSet probes: hash & (capacity - 1),
+//   then the next slot.
+//   Rows are flagged "skewed" (spread > 1.1), "weak" (bias > 0.5), "collides"
+//   (any coll64) or "clustered" (table misses over 1.5x the random-hash
+//   expectation for linear probing, (1 + 1/(1-a)^2)/2 - 1 at load a): keep
+//   those away from production keys. Sequential keys can spread evenly and
+//   still cluster, because they land in runs of adjacent slots.
+template <typename Func>
+double secondsOf(Func func) {
+    auto start = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+template <typename HashFunc>
+void throughputRow(const string& name, const vector<string>& keys, size_t rounds) {
+    HashFunc hash;
+    size_t sink = 0, bytes = 0;
+    for (const string& k : keys) bytes += k.size();
+    double t = secondsOf([&] {
+        for (size_t r = 0; r < rounds; r++)
+            for (const string& k : keys) sink += hash(k);
+    });
+    size_t calls = keys.size() * rounds;
+    cout << "  " << name << "  " << t * 1e9 / calls << " ns/key  " << bytes * rounds / t / 1e9 << " GB/s"
+         << (sink == 42 ? " " : "") << "\n";
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+static constexpr const char* TICK = "cycle";
+static inline uint64_t ticks() { return __rdtsc(); }   // constant-rate TSC: close to core cycles
+#else
+static constexpr const char* TICK = "ns";
+static inline uint64_t ticks() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+static size_t keyBytes(const string& key) { return key.size(); }
+static size_t keyBytes(uint64_t) { return sizeof(uint64_t); }
+static void flipBit(string& key, size_t bit) { key[bit / 8] ^= (char)(1 << (bit % 8)); }
+static void flipBit(uint64_t& key, size_t bit) { key ^= 1ULL << bit; }
+
+// Flip each of the first 256 input bits of sampled keys and count which of
+// the 64 output bits change. Returns {mean flip share, worst cell bias}.
+template <typename HashFunc, typename Key>
+pair<double, double> avalanche(const vector<Key>& keys) {
+    constexpr size_t IN_BITS = 256, MIN_TRIALS = 100;
+    HashFunc hash;
+    vector<uint32_t> flips(IN_BITS * 64, 0), trials(IN_BITS, 0);
+    uint64_t flipped = 0, total = 0;
+    for (size_t k = 0; k < keys.size(); k += max<size_t>(1, keys.size() / 1000)) {
+        Key key = keys[k];
+        uint64_t base = hash(key);
+        for (size_t bit = 0; bit < min(keyBytes(key) * 8, IN_BITS); bit++) {
+            flipBit(key, bit);
+            uint64_t diff = base ^ (uint64_t)hash(key);
+            flipBit(key, bit);
+            trials[bit]++;
+            flipped += __builtin_popcountll(diff);
+            total += 64;
+            for (int out = 0; out < 64; out++) flips[bit * 64 + out] += (diff >> out) & 1;
+        }
+    }
+    double worst = 0;
+    for (size_t bit = 0; bit < IN_BITS; bit++)
+        if (trials[bit] >= MIN_TRIALS)
+            for (int out = 0; out < 64; out++)
+                worst = max(worst, fabs(2.0 * flips[bit * 64 + out] / trials[bit] - 1));
+    return {(double)flipped / max<uint64_t>(total, 1), worst};
+}
+
+// Expected probes past the home slot for a linear-probing miss at load 0.7
+static const double LINEAR_MISS_AT_07 = (1 + 1 / ((1 - 0.7) * (1 - 0.7))) / 2 - 1;
+
+// Mean probes per hit and per miss for integer keys in a linear-probing
+// table laid out like HashSet's: cap slots holding `fill` keys.
+template <typename HashFunc>
+pair<double, double> setProbes(const vector<uint64_t>& present, const vector<uint64_t>& absent, size_t cap,
+                               size_t fill) {
+    HashFunc hash;
+    vector<uint64_t> slots(cap);
+    vector<bool> used(cap, false);
+    for (size_t i = 0; i < fill; i++) {
+        size_t idx = hash(present[i]) & (cap - 1);
+        while (used[idx]) idx = (idx + 1) & (cap - 1);
+        slots[idx] = present[i];
+        used[idx] = true;
+    }
+    auto walk = [&](uint64_t key) {
+        size_t idx = hash(key) & (cap - 1), probes = 0;
+        while (used[idx] && slots[idx] != key) idx = (idx + 1) & (cap - 1), probes++;
+        return probes;
+    };
+    uint64_t hit = 0, miss = 0;
+    size_t misses = min(fill, absent.size());
+    for (size_t i = 0; i < fill; i++) hit += walk(present[i]);
+    for (size_t i = 0; i < misses; i++) miss += walk(absent[i]);
+    return {(double)hit / max<size_t>(fill, 1), (double)miss / max<size_t>(misses, 1)};
+}
+
+template <typename HashFunc, typename Key>
+void hashReport(const string& name, const vector<Key>& present, const vector<Key>& absent) {
+    HashFunc hash;
+    size_t sample = min<size_t>(present.size(), 4096), bytes = 0, sink = 0;
+    for (size_t i = 0; i < sample; i++) bytes += keyBytes(present[i]);
+    size_t rounds = max<size_t>(1, (16u << 20) / max<size_t>(bytes, 1));
+    uint64_t t0 = ticks();
+    for (size_t r = 0; r < rounds; r++)
+        for (size_t i = 0; i < sample; i++) sink += hash(present[i]);
+    double perTick = (double)bytes * rounds / max<uint64_t>(ticks() - t0, 1);
+
+    auto [flipShare, bias] = avalanche<HashFunc>(present);
+
+    size_t n = present.size(), buckets = 1;
+    while (buckets < n) buckets *= 2;
+    vector<uint64_t> full(n);
+    vector<uint32_t> load(buckets, 0);
+    for (size_t i = 0; i < n; i++) {
+        full[i] = hash(present[i]);
+        load[full[i] & (buckets - 1)]++;
+    }
+    double squares = 0;
+    for (uint32_t c : load) squares += (double)c * c;
+    double spread = squares / (n + (double)n * (n - 1) / buckets);
+    uint32_t largest = *max_element(load.begin(), load.end());
+    sort(full.begin(), full.end());
+    size_t collisions = n - (unique(full.begin(), full.end()) - full.begin());
+
+    // Each table filled right up to its growth threshold, the heaviest load
+    // it ever runs at: the largest power-of-two capacity that the keys can
+    // fill to maxLoad, then that many keys looked up, and as many misses.
+    // A corpus too small for 16 slots fills them with all it has.
+    auto probes = [&](double maxLoad) {
+        size_t cap = 16;
+        while (cap * 2 * maxLoad <= n) cap *= 2;
+        size_t fill = min(n, (size_t)(cap * maxLoad));
+        if constexpr (is_same_v<Key, string>) {
+            HashTable<HashFunc, ProbeStats, LinearProbe> table(cap, 0.95);
+            for (size_t i = 0; i < fill; i++) table.insert(present[i]);
+            for (size_t i = 0; i < fill; i++) table.find(present[i]);
+            for (size_t i = 0; i < min(fill, absent.size()); i++) table.find(absent[i]);
+            return make_pair(table.stats().mean_hit_probes(), table.stats().mean_miss_probes());
+        } else {
+            return setProbes<HashFunc>(present, absent, cap, fill);
+        }
+    };
+    auto [tableHit, tableMiss] = probes(0.7);
+    auto [setHit, setMiss] = probes(0.6);
+
+    cout << "  " << name << "  " << perTick << "  " << flipShare << "  " << bias << "  " << spread << "  "
+         << largest << "  " << collisions << "  " << tableHit << "/" << tableMiss << "  " << setHit << "/"
+         << setMiss << (spread > 1.1 ? "  skewed" : "") << (bias > 0.5 ? "  weak" : "")
+         << (collisions ? "  collides" : "") << (tableMiss > 1.5 * LINEAR_MISS_AT_07 ? "  clustered" : "")
+         << (sink == 42 ? " " : "") << "\n";
+}
+
+int runHashBenchmark(int argc, char** argv) {
+    size_t n = argc > 2 ? stoul(argv[2]) : 1000000;
+    mt19937_64 rng(42);
+    auto randomString = [&](size_t len) {
+        string s(len, ' ');
+        for (char& c : s) c = (char)(' ' + rng() % 95);
+        return s;
+    };
+
+    cout << "throughput (4096 keys per length, " << "hashed repeatedly)\n";
+    for (size_t len : {8, 16, 40, 100, 200, 400, 1000}) {
+        vector<string> keys;
+        for (int i = 0; i < 4096; i++) keys.push_back(randomString(len));
+        size_t rounds = max<size_t>(1, (64u << 20) / (4096 * len));
+        cout << "len " << len << "\n";
+        throughputRow<SimpleHash>("SimpleHash    ", keys, rounds);
+        throughputRow<WyHash>("WyHash        ", keys, rounds);
+        throughputRow<Xxh3ScalarHash>("Xxh3ScalarHash", keys, rounds);
+        throughputRow<Xxh3Hash>("Xxh3Hash      ", keys, rounds);
+    }
+
+    // Corpora: 2n keys, deduplicated and shuffled; the first half is
+    // inserted, the second half is looked up as misses.
+    const char* hosts[] = {"www.example.com", "api.example.com", "cdn.example.net", "shop.example.org"};
+    const char* paths[] = {"/products/", "/users/", "/api/v2/orders/", "/static/img/", "/search?q="};
+    string prefix = randomString(100), base = randomString(64);
+    vector<pair<string, function<string(size_t)>>> corpora = {
+        {"sequential ints as decimal strings", [](size_t i) { return to_string(i); }},
+        {"strided ints (x4096) as decimal strings", [](size_t i) { return to_string(i * 4096); }},
+        {"URLs", [&](size_t i) {
+             return string("https://") + hosts[rng() % 4] + paths[rng() % 5] + to_string(i) + "?ref=" +
+                    to_string(rng() % 100);
+         }},
+        {"UUIDs", [&](size_t) {
+             static const char hex[] = "0123456789abcdef";
+             string u = "xxxxxxxx-xxxx-4xxx-yxxx-xxxxxxxxxxxx";
+             for (char& c : u)
+                 if (c == 'x') c = hex[rng() % 16];
+                 else if (c == 'y') c = hex[8 + rng() % 4];
+             return u;
+         }},
+        {"short words (3-8 letters)", [&](size_t) {
+             string w(3 + rng() % 6, ' ');
+             for (char& c : w) c = (char)('a' + rng() % 26);
+             return w;
+         }},
+        {"shared 100-byte prefix + <i>", [&](size_t i) { return prefix + to_string(i); }},
+        {"64 bytes, counter xor'd into the middle", [&](size_t i) {
+             string mixed = base;
+             for (int b = 0; b < 4; b++) mixed[30 + b] ^= (char)(i >> (8 * b));
+             return mixed;
+         }},
+    };
+
+    cout << "\nreport (" << n << " keys per corpus; random-hash table miss " << LINEAR_MISS_AT_07 << ")\n";
+    cout << "  functor  B/" << TICK << "  aval  bias  spread  max_bucket  coll64  table_hit/miss  set_hit/miss\n";
+    for (auto& [name, make] : corpora) {
+        vector<string> keys;
+        for (size_t i = 0; i < 2 * n; i++) keys.push_back(make(i));
+        sort(keys.begin(), keys.end());
+        keys.erase(unique(keys.begin(), keys.end()), keys.end());
+        shuffle(keys.begin(), keys.end(), rng);
+        vector<string> absent(keys.begin() + keys.size() / 2, keys.end());
+        keys.resize(keys.size() / 2);
+
+        cout << name << "\n";
+        hashReport<SimpleHash>("SimpleHash", keys, absent);
+        hashReport<WyHash>("WyHash    ", keys, absent);
+        hashReport<Xxh3Hash>("Xxh3Hash  ", keys, absent);
+    }
+
+    // The same integers as HashSet<uint64_t> sees them: hashed as integers by
+    // its Hash parameter. Keys are distinct by construction.
+    vector<pair<string, function<uint64_t(size_t)>>> intCorpora = {
+        {"sequential uint64", [](size_t i) { return (uint64_t)i; }},
+        {"strided uint64 (x4096)", [](size_t i) { return (uint64_t)i * 4096; }},
+    };
+    for (auto& [name, make] : intCorpora) {
+        vector<uint64_t> keys;
+        for (size_t i = 0; i < 2 * n; i++) keys.push_back(make(i));
+        shuffle(keys.begin(), keys.end(), rng);
+        vector<uint64_t> absent(keys.begin() + keys.size() / 2, keys.end());
+        keys.resize(keys.size() / 2);
+
+        cout << name << "\n";
+        hashReport<IdentityHash<uint64_t>>("IdentityHash", keys, absent);
+        hashReport<SetHash<uint64_t>>("SetHash     ", keys, absent);
+    }
+    return 0;
+}
+
+// ------------------ Arena Benchmark ------------------
+// Usage: ./functor_hash arena [keys=2000000]
+// HashTable<WyHash> (std::string per slot) against ArenaHashTable<WyHash>
+// on long (40-200 byte) and short (8-15 byte, inside std::string's
+// small-string buffer) keys: insert, hit and miss time, heap allocations
+// for key storage and memory. HashTable memory is estimated as slots *
+// (sizeof(string) + 1 state byte), plus len + 1 rounded up to 16 for every
+// key too long for the small-string buffer -- a lower bound, since malloc's
+// per-block headers are not counted. ArenaHashTable reports its exact
+// allocation, arena slack included.
+template <typename Table>
+void arenaRow(const string& name, const vector<string>& keys, const vector<string>& absent,
+              size_t allocations, size_t bytes) {
+    Table table;
+    double build = secondsOf([&] { for (const string& k : keys) table.insert(k); });
+    size_t hits = 0;
+    double hit = secondsOf([&] { for (const string& k : keys) hits += table.find(k); });
+    double miss = secondsOf([&] { for (const string& k : absent) hits += table.find(k); });
+    size_t n = keys.size();
+    cout << "  " << name << "  " << build * 1e9 / n << "  " << hit * 1e9 / n << "  " << miss * 1e9 / n << "  "
+         << allocations << "  " << bytes / 1048576.0 << (hits != n ? "  (wrong results!)" : "") << "\n";
+}
+
+int runArenaBenchmark(int argc, char** argv) {
+    size_t n = argc > 2 ? stoul(argv[2]) : 2000000;
+    mt19937_64 rng(42);
+    auto randomString = [&](size_t len) {
+        string s(len, ' ');
+        for (char& c : s) c = (char)(' ' + rng() % 95);
+        return s;
+    };
+
+    cout << "table  insert_ns  hit_ns  miss_ns  key_allocations  MiB\n";
+    for (auto [minLen, maxLen] : { pair<size_t, size_t>{40, 200}, pair<size_t, size_t>{8, 15} }) {
+        vector<string> keys, absent;
+        for (size_t i = 0; i < n; i++) {
+            keys.push_back(randomString(minLen + rng() % (maxLen - minLen + 1)));
+            absent.push_back(randomString(minLen + rng() % (maxLen - minLen + 1)));
+        }
+        HashTable<WyHash> sizing;
+        ArenaHashTable<WyHash> arenaSizing;
+        size_t heapKeys = 0, longKeys = 0;
+        for (const string& k : keys) {
+            sizing.insert(k);
+            arenaSizing.insert(k);
+            if (k.size() > 15) {
+                longKeys++;
+                heapKeys += (k.size() + 1 + 15) / 16 * 16;
+            }
+        }
+        cout << minLen << "-" << maxLen << " byte keys\n";
+        arenaRow<HashTable<WyHash>>("HashTable     ", keys, absent, longKeys,
+                                    sizing.capacity() * (sizeof(string) + 1) + heapKeys);
+        arenaRow<ArenaHashTable<WyHash>>("ArenaHashTable", keys, absent, 0, arenaSizing.memory_bytes());
+    }
+    return 0;
+}
+
+// ------------------ Sharded Benchmark ------------------
+// Usage: ./functor_hash sharded [keys=4000000] [max_threads=16]
+// Ingestion as the parser threads do it: every thread inserts its slice of
+// a key stream (40-100 byte strings, each distinct key appearing twice)
+// into one table. One HashTable<WyHash> behind a single mutex is compared
+// with ShardedHashTable<WyHash> (64 shards) at 1, 2, 4, ... threads, and the
+// final size() is checked against the number of distinct keys.
+template <typename Insert>
+double ingest(const vector<string>& stream, unsigned threads, Insert insert) {
+    return secondsOf([&] {
+        vector<thread> pool;
+        for (unsigned t = 0; t < threads; t++)
+            pool.emplace_back([&, t] {
+                size_t lo = stream.size() * t / threads, hi = stream.size() * (t + 1) / threads;
+                for (size_t i = lo; i < hi; i++) insert(stream[i]);
+            });
+        for (auto& th : pool) th.join();
+    });
+}
+
+int runShardedBenchmark(int argc, char** argv) {
+    size_t n = argc > 2 ? stoul(argv[2]) : 4000000;
+    unsigned maxThreads = argc > 3 ? stoul(argv[3]) : 16;
+    mt19937_64 rng(42);
+    vector<string> distinct(n / 2), stream;
+    for (size_t i = 0; i < distinct.size(); i++) {
+        distinct[i] = to_string(i) + ":";
+        distinct[i].resize(40 + rng() % 61, 'a' + (char)(rng() % 26));
+    }
+    stream = distinct;
+    stream.insert(stream.end(), distinct.begin(), distinct.end());
+    shuffle(stream.begin(), stream.end(), rng);
+
+    cout << n << " inserts, " << distinct.size() << " distinct keys, " << thread::hardware_concurrency()
+         << " hardware threads\n";
+    cout << "threads  global_lock_Mops  sharded_Mops\n";
+    for (unsigned t = 1; t <= maxThreads; t *= 2) {
+        HashTable<WyHash> single;
+        mutex global;
+        double locked = ingest(stream, t, [&](const string& k) {
+            lock_guard<mutex> guard(global);
+            single.insert(k);
+        });
+        ShardedHashTable<WyHash> sharded(64);
+        double split = ingest(stream, t, [&](const string& k) { sharded.insert(k); });
+        bool ok = single.size() == distinct.size() && sharded.size() == distinct.size();
+        cout << t << "  " << n / locked / 1e6 << "  " << n / split / 1e6 << (ok ? "" : "  (wrong size!)") << "\n";
+    }
+    return 0;
+}
+
+// ------------------ Probe Benchmark ------------------
+// Usage: ./functor_hash probe [capacity=1048576]
+// Probe policy x hash functor x load factor. Each cell fills a table of
+// fixed capacity (max_load 0.95, so it never grows) to the target load,
+// then looks up every key (hits) and as many absent keys (misses).
+// Reported: mean probes past the home slot and ns per lookup, for each.
+// Keys share long prefixes ("/api/v1/users/<id>/profile"), which is where
+// SimpleHash clusters and the probe order matters.
+template <typename HashFunc, typename Probe>
+void probeRow(const char* name, const vector<string>& present, const vector<string>& absent, size_t cap) {
+    HashTable<HashFunc, ProbeStats, Probe> table(cap, 0.95);
+    for (const string& k : present) table.insert(k);
+    table.reset_stats();
+    size_t found = 0;
+    double hit = secondsOf([&] {
+        for (const string& k : present) found += table.find(k);
+    });
+    double miss = secondsOf([&] {
+        for (const string& k : absent) found += table.find(k);
+    });
+    const ProbeStats& st = table.stats();
+    cout << "  " << name << "  " << st.mean_hit_probes() << "  " << hit * 1e9 / present.size() << "  "
+         << st.mean_miss_probes() << "  " << miss * 1e9 / absent.size()
+         << (found == present.size() && table.capacity() == cap ? "" : "  (wrong!)") << "\n";
+}
+
+template <typename HashFunc>
+void probeRows(const char* hashName, const vector<string>& present, const vector<string>& absent, size_t cap) {
+    cout << " " << hashName << "\n";
+    probeRow<HashFunc, LinearProbe>("linear   ", present, absent, cap);
+    probeRow<HashFunc, QuadraticProbe>("quadratic", present, absent, cap);
+    probeRow<HashFunc, DoubleHashProbe>("double   ", present, absent, cap);
+}
+
+int runProbeBenchmark(int argc, char** argv) {
+    size_t cap = argc > 2 ? stoul(argv[2]) : 1 << 20;
+    auto key = [](size_t i) { return "/api/v1/users/" + to_string(i) + "/profile"; };
+
+    cout << "capacity " << cap << "; per policy: hit_probes  hit_ns  miss_probes  miss_ns\n";
+    for (double load : {0.5, 0.7, 0.9}) {
+        size_t n = (size_t)(cap * load);
+        vector<string> present, absent;
+        for (size_t i = 0; i < n; i++) {
+            present.push_back(key(2 * i));
+            absent.push_back(key(2 * i + 1));
+        }
+        mt19937_64 rng(42);
+        shuffle(present.begin(), present.end(), rng);
+        shuffle(absent.begin(), absent.end(), rng);
+
+        cout << "load " << load << "\n";
+        probeRows<SimpleHash>("SimpleHash", present, absent, cap);
+        probeRows<WyHash>("WyHash", present, absent, cap);
+    }
+    return 0;
+}
+
+// Keyword set for the perfect-hash demo, checked at compile time.
+constexpr string_view HEADER_FIELDS[] = {
+    "accept", "accept-encoding", "accept-language", "authorization", "cache-control",
+    "connection", "content-length", "content-type", "cookie", "date", "etag", "expires",
+    "host", "if-modified-since", "if-none-match", "last-modified", "location", "origin",
+    "range", "referer", "server", "set-cookie", "transfer-encoding", "user-agent", "vary"};
+constexpr auto HEADER_HASH = PerfectHash<size(HEADER_FIELDS)>::build(HEADER_FIELDS);
+static_assert(HEADER_HASH.contains("content-type") && !HEADER_HASH.contains("content-typo"));
+
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "hashbench")
+        return runHashBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "arena")
+        return runArenaBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "sharded")
+        return runShardedBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "probe")
+        return runProbeBenchmark(argc, argv);
+
     HashTable<SimpleHash> ht;
 
-    ht.insert("apple");
-    ht.insert("banana");
-    ht.insert("orange");
-    ht.insert("grape");
+    cout << "Inserting ...\n";
+    for (const char* key : { "apple", "banana", "orange", "grape", "apple" })
+        cout << key << ": " << (ht.insert(key) ? "inserted" : "already present") << endl;
 
     cout << "\nFinding ...\n";
-    ht.find("banana");
-    ht.find("grape");
+    cout << "banana: " << ht.find("banana") << endl;
+    cout << "grape: " << ht.find("grape") << endl;
 
     cout << "\nRemoving ...\n";
-    ht.remove("banana");
-    ht.remove("grape");
+    cout << "banana: " << ht.remove("banana") << endl;
+    cout << "grape: " << ht.remove("grape") << endl;
+    cout << "kiwi: " << ht.remove("kiwi") << endl;
 
     cout << "\nFinding after removal...\n";
-    ht.find("banana");
-    ht.find("grape");
+    cout << "banana: " << ht.find("banana") << endl;
+    cout << "grape: " << ht.find("grape") << endl;
+
+    // Far past the old fixed 10 slots
+    cout << "\nGrowing ...\n";
+    for (int i = 0; i < 1000000; i++)
+        ht.insert("key" + to_string(i));
+    cout << "size " << ht.size() << ", capacity " << ht.capacity()
+         << ", load " << ht.load_factor() << endl;
+    cout << "key999999: " << ht.find("key999999") << endl;
+
+    // Same table with a word-at-a-time hash
+    HashTable<WyHash> wide;
+    for (int i = 0; i < 1000000; i++)
+        wide.insert("key" + to_string(i));
+    cout << "WyHash table: size " << wide.size() << ", key999999: " << wide.find("key999999") << endl;
+
+    // Fixed keyword set: collision-free by construction
+    cout << "\nPerfect hash (" << size(HEADER_FIELDS) << " keys, " << HEADER_HASH.SLOTS << " slots) ...\n";
+    for (const char* field : { "host", "etag", "x-forwarded-for" })
+        cout << field << ": " << HEADER_HASH.contains(field) << ", slot " << HEADER_HASH.slot(field) << endl;
+    HashTable<PerfectHashFunc<HEADER_HASH>, ProbeStats> headers(HEADER_HASH.SLOTS, 0.8);
+    for (string_view field : HEADER_FIELDS)
+        headers.insert(string(field));
+    for (string_view field : HEADER_FIELDS)
+        headers.find(string(field));
+    cout << headers.stats_json() << endl;
+
+    // Key bytes in one arena instead of a std::string per slot
+    ArenaHashTable<WyHash> packed;
+    for (int i = 0; i < 1000000; i++)
+        packed.insert("key" + to_string(i));
+    for (int i = 0; i < 1000000; i += 2)
+        packed.remove("key" + to_string(i));
+    cout << "Arena table: size " << packed.size() << ", key999999: " << packed.find("key999999")
+         << ", key0: " << packed.find("key0") << ", " << packed.memory_bytes() / 1048576.0 << " MiB" << endl;
+
+    // Many writers: one lock per shard instead of one for the table
+    ShardedHashTable<WyHash> shared;
+    vector<thread> writers;
+    for (int t = 0; t < 4; t++)
+        writers.emplace_back([&shared, t] {
+            for (int i = 0; i < 100000; i++) shared.insert("key" + to_string(i * 4 + t));
+        });
+    for (auto& w : writers) w.join();
+    size_t visited = 0;
+    shared.for_each([&](string_view) { visited++; });
+    cout << "Sharded table: size " << shared.size() << " in " << shared.shard_count() << " shards, visited "
+         << visited << endl;
+
+    cout << "\nInstrumented table ...\n";
+    HashTable<SimpleHash, ProbeStats> probed;
+    for (int i = 0; i < 1000; i++)
+        probed.insert("key" + to_string(i));
+    for (int i = 0; i < 1000; i += 3)
+        probed.remove("key" + to_string(i));
+    for (int i = 0; i < 2000; i++)
+        probed.find("key" + to_string(i));
+    cout << probed.stats_json() << endl;
 
     return 0;
 }
@@ -0,0 +1,53 @@
+// Hash functors of the sets in unordered_set_buggy.cpp, shared with the
+// hashbench report in functor_hash.cpp so integer keys are measured with
+// the functions HashSet really uses.
+//
+// A hash functor maps a key to 64 bits; the tables use power-of-two
+// capacities and keep the low bits (h & (capacity - 1)), so every bit of
+// the result must depend on the key.
+#ifndef SET_HASH_H
+#define SET_HASH_H
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+// The original HashSet hash: the integer itself, or h = h * 131 + c for
+// strings. Fine with `% prime`, but with a power-of-two mask it keeps only
+// the low bits -- keys that are multiples of 64 all land in 1/64 of the slots.
+template <typename T>
+struct IdentityHash {
+    uint64_t operator()(const T& key) const {
+        if constexpr (std::is_integral_v<T>) {
+            return static_cast<uint64_t>(key);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            uint64_t h = 0;
+            for (char c : key) {
+                h = h * 131 + static_cast<unsigned char>(c);
+            }
+            return h;
+        } else {
+            static_assert(sizeof(T) == 0, "Hash not implemented for this type");
+        }
+    }
+};
+
+// Default hash: the identity/131 base hash followed by a multiply-xorshift
+// finalizer (murmur3 fmix64), so low and high bits both depend on every
+// input bit. Two multiplies and three shifts, no division.
+template <typename T>
+struct SetHash {
+    uint64_t seed = 0;   // per-table salt; HashSet::save() persists it with the table
+
+    uint64_t operator()(const T& key) const {
+        uint64_t h = IdentityHash<T>()(key) ^ seed;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+#endif // SET_HASH_H
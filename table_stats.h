@@ -0,0 +1,77 @@
+// Stats policies for the open-addressing tables in unordered_set_buggy.cpp
+// (HashSet) and functor_hash.cpp (HashTable, ArenaHashTable). A table calls
+// the hooks below on every lookup and rehash.
+//
+// NoStats (the default) is an empty struct with empty inline hooks, and
+// enabled = false lets tables skip the rehash timer. Tables hold it as a
+// [[no_unique_address]] member, so an uninstrumented table has the same
+// code and the same layout as one without the parameter.
+//
+// ProbeStats keeps probe-length histograms of hits and misses (probes =
+// slots stepped past the home slot), exact probe totals for the means, and
+// rehash count/time.
+#ifndef TABLE_STATS_H
+#define TABLE_STATS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct NoStats {
+    static constexpr bool enabled = false;
+    void record_hit(size_t) {}
+    void record_miss(size_t) {}
+    void record_rehash(double) {}
+    void reset() {}
+    void append_json(std::string&) const {}
+};
+
+struct ProbeStats {
+    static constexpr bool enabled = true;
+    static constexpr size_t BUCKETS = 32;   // probe lengths 0..30; the last bucket counts >= 31
+
+    uint64_t hit_hist[BUCKETS] = {};
+    uint64_t miss_hist[BUCKETS] = {};
+    uint64_t hit_probes = 0, miss_probes = 0;   // sums, not capped like the histograms
+    uint64_t rehashes = 0;
+    double rehash_seconds = 0;
+
+    void record_hit(size_t probes) {
+        ++hit_hist[std::min(probes, BUCKETS - 1)];
+        hit_probes += probes;
+    }
+    void record_miss(size_t probes) {
+        ++miss_hist[std::min(probes, BUCKETS - 1)];
+        miss_probes += probes;
+    }
+    void record_rehash(double seconds) {
+        ++rehashes;
+        rehash_seconds += seconds;
+    }
+    void reset() { *this = ProbeStats(); }
+
+    static uint64_t total(const uint64_t* h) {
+        uint64_t n = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) n += h[i];
+        return n;
+    }
+    double mean_hit_probes() const { return (double)hit_probes / std::max<uint64_t>(total(hit_hist), 1); }
+    double mean_miss_probes() const { return (double)miss_probes / std::max<uint64_t>(total(miss_hist), 1); }
+
+    void append_json(std::string& out) const {
+        auto hist = [&](const char* name, const uint64_t* h) {
+            out += std::string(",\"") + name + "\":[";
+            for (size_t i = 0; i < BUCKETS; ++i) out += (i ? "," : "") + std::to_string(h[i]);
+            out += "]";
+        };
+        hist("hit_probe_hist", hit_hist);
+        hist("miss_probe_hist", miss_hist);
+        out += ",\"mean_hit_probes\":" + std::to_string(mean_hit_probes());
+        out += ",\"mean_miss_probes\":" + std::to_string(mean_miss_probes());
+        out += ",\"rehashes\":" + std::to_string(rehashes);
+        out += ",\"rehash_seconds\":" + std::to_string(rehash_seconds);
+    }
+};
+
+#endif // TABLE_STATS_H
@@ -1,6 +1,32 @@
 #include <iostream>
 #include <string>
 #include <cstring>  
+#include <cstdlib>
+#include <cstdint>
+#include <utility>
+#include <new>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <limits>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <cstddef>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "set_hash.h"
+#include "table_stats.h"
 using namespace std;
 
 template <typename T>
@@ -12,9 +38,108 @@ public:
     virtual ~Set() = default; // base virtual destructor
 };
 
-// A simple hash-based Set implementation using open addressing (linear probing)
-template <typename T>
-class HashSet : public Set<T> {
+// Static (compile-time) counterpart of Set<T>, via CRTP.
+// An implementation derives from StaticSet<Impl, T> and provides
+//   template <typename K> bool insert_impl(K&& key);   // K is T, T& or const T&
+//   bool find_impl(const T& key) const;
+//   void remove_impl(const T& key);
+// Code written against StaticSet<Impl, T>& (or templated on the set type)
+// calls these directly: no vtable load, the call can be inlined, and keys are
+// passed by reference instead of being copied into a by-value T parameter.
+template <typename Derived, typename T>
+class StaticSet {
+public:
+    template <typename K>
+    bool add(K&& key) {
+        if constexpr (is_same_v<decay_t<K>, T>)
+            return self().insert_impl(std::forward<K>(key));
+        else
+            return self().insert_impl(T(std::forward<K>(key)));  // e.g. const char* -> string, once
+    }
+
+    bool contains(const T& key) const { return self().find_impl(key); }
+
+    void erase(const T& key) { self().remove_impl(key); }
+
+private:
+    Derived& self() { return static_cast<Derived&>(*this); }
+    const Derived& self() const { return static_cast<const Derived&>(*this); }
+};
+
+// ------------------ Hash functors ------------------
+// The sets below take the hash as a template parameter: SetHash (the
+// default) or IdentityHash, from set_hash.h, shared with functor_hash.cpp.
+
+// ------------------ Blocked Bloom filter ------------------
+// Bloom filter made of 64-byte blocks, each one cache line of 8 x 64-bit
+// words. A key selects one block and sets one bit in each of its 8 words,
+// so a query reads exactly one cache line (a "split block" Bloom filter).
+// Works on the 64-bit hash the table already computed. It does not support
+// removal; the owner rebuilds it instead.
+class BlockedBloomFilter {
+private:
+    struct alignas(64) Block {
+        uint64_t words[8];
+    };
+
+    vector<Block> blocks;   // empty when disabled
+
+    static constexpr uint32_t SALT[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                         0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+    // Remix so that identity-like hashes still spread over blocks and bits,
+    // and the block index is independent of the table's low-bit slot index.
+    static uint64_t remix(uint64_t h) { return h * 0x9E3779B97F4A7C15ULL; }
+
+    // Block index: high 32 bits scaled to [0, blocks) (multiply-shift, no division).
+    size_t blockIndex(uint64_t x) const { return ((x >> 32) * blocks.size()) >> 32; }
+
+public:
+    // Size for `keys` keys at bits_per_key and clear all bits.
+    // keys == 0 disables the filter.
+    void reset(size_t keys, double bits_per_key) {
+        blocks.clear();
+        if (keys == 0) return;
+        blocks.assign((size_t)(keys * bits_per_key / 512) + 1, Block{});
+    }
+
+    bool enabled() const { return !blocks.empty(); }
+
+    void add(uint64_t h) {
+        uint64_t x = remix(h);
+        Block& b = blocks[blockIndex(x)];
+        uint32_t lo = (uint32_t)x;
+        for (int i = 0; i < 8; ++i)
+            b.words[i] |= 1ULL << ((lo * SALT[i]) >> 26);
+    }
+
+    bool may_contain(uint64_t h) const {
+        uint64_t x = remix(h);
+        const Block& b = blocks[blockIndex(x)];
+        uint32_t lo = (uint32_t)x;
+        bool hit = true;
+        for (int i = 0; i < 8; ++i)
+            hit &= (b.words[i] >> ((lo * SALT[i]) >> 26)) & 1;
+        return hit;
+    }
+
+    void prefetch(uint64_t h) const {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&blocks[blockIndex(remix(h))]);
+#endif
+    }
+
+    size_t memory_bytes() const { return blocks.size() * sizeof(Block); }
+};
+
+// ------------------ Table statistics ------------------
+// HashSet's third template parameter: NoStats (the default) or ProbeStats,
+// from table_stats.h, shared with functor_hash.cpp.
+
+// A simple hash-based Set implementation using open addressing (linear probing).
+// Capacity is a power of two, so the home slot is hash & (capacity - 1).
+template <typename T, typename Hash = SetHash<T>, typename Stats = NoStats>
+class HashSet : public Set<T>, public StaticSet<HashSet<T, Hash, Stats>, T> {
 private:
     enum SlotState { EMPTY, OCCUPIED, DELETED };
 
@@ -25,53 +150,337 @@ private:
     };
 
     Slot* table;
-    size_t capacity;
+    size_t capacity;      // power of two
     size_t size_;
+    size_t tombstones = 0;     // DELETED slots
+    Hash hasher;
+    void* mapping = nullptr;   // non-null when table lives in a mapped snapshot (see load())
+    size_t mapping_bytes = 0;
     static constexpr double load_factor_threshold = 0.6;
+    BlockedBloomFilter filter;   // optional front-end for misses (see enable_filter())
+    double filter_bits_per_key = 0;
+    [[no_unique_address]] mutable Stats stats_;        // lookups are const but still counted
+    unsigned threads_ = 1;       // used by rehash() of large tables (see set_threads())
+    static constexpr size_t PARALLEL_MIN = 1 << 16;   // smaller tables rehash serially
+
+    // Snapshot file header; the slot array follows at SNAPSHOT_DATA_OFFSET.
+    struct SnapshotHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t slot_bytes;          // sizeof(Slot) of the writer
+        uint64_t capacity;
+        uint64_t size;
+        uint64_t tombstones;
+        unsigned char hash_state[16]; // bytes of the Hash object (e.g. SetHash::seed)
+        uint64_t data_checksum;       // over the slot array
+        uint64_t header_checksum;     // over all fields above
+    };
+    static constexpr char SNAPSHOT_MAGIC[8] = {'H', 'S', 'E', 'T', 'S', 'N', 'A', 'P'};
+    static constexpr uint32_t SNAPSHOT_VERSION = 2;
+    static constexpr size_t SNAPSHOT_DATA_OFFSET = 4096;   // keeps the slot array page aligned
 
-    // Simple hash function for integers and strings
+    // Word-at-a-time checksum (multiply-xorshift per 8 bytes).
+    static uint64_t checksum(const void* data, size_t bytes) {
+        return checksumStep(0x9E3779B97F4A7C15ULL ^ bytes, data, bytes);
+    }
+
+    // checksum() of `total` bytes fed in pieces: start from
+    // 0x9E3779B97F4A7C15 ^ total. Every piece but the last must be a
+    // multiple of 8 bytes, so the words line up as in a single call.
+    static uint64_t checksumStep(uint64_t h, const void* data, size_t bytes) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        size_t i = 0;
+        for (; i + 8 <= bytes; i += 8) {
+            uint64_t w;
+            memcpy(&w, p + i, 8);
+            h = (h ^ w) * 0xff51afd7ed558ccdULL;
+            h ^= h >> 32;
+        }
+        for (; i < bytes; ++i)
+            h = (h ^ p[i]) * 0x100000001b3ULL;
+        return h;
+    }
+
+    // Free a slot array: heap-allocated, or a mapped snapshot.
+    static void freeSlots(Slot* slots, void* map, size_t map_bytes) {
+        if (map)
+            munmap(map, map_bytes);
+        else
+            delete[] slots;
+    }
+
+    void releaseTable() {
+        freeSlots(table, mapping, mapping_bytes);
+        table = nullptr;
+        mapping = nullptr;
+        mapping_bytes = 0;
+    }
+
+    // Home slot of key
     size_t hash(const T& key) const {
-        if constexpr (is_integral_v<T>) {
-            return static_cast<size_t>(key) % capacity;
-        } else if constexpr (is_same_v<T, string>) {
-            size_t h = 0;
-            for (char c : key) {
-                h = h * 131 + static_cast<unsigned char>(c);
-            }
-            return h % capacity;
+        return static_cast<size_t>(hasher(key)) & (capacity - 1);
+    }
+
+    // Size the filter for a full table at the current capacity.
+    void resetFilter() {
+        filter.reset((size_t)(capacity * load_factor_threshold) + 1, filter_bits_per_key);
+    }
+
+    void rebuildFilter() {
+        resetFilter();
+        for (size_t i = 0; i < capacity; ++i)
+            if (table[i].state == OCCUPIED)
+                filter.add(hasher(table[i].value));
+    }
+
+    static int log2Pow2(size_t n) {
+        int bits = 0;
+        while ((size_t(1) << bits) < n) ++bits;
+        return bits;
+    }
+
+    static size_t roundUpPow2(size_t n) {
+        size_t cap = 1;
+        while (cap < n) cap *= 2;
+        return cap;
+    }
+
+    void rehash() {
+        rehash(max<size_t>(capacity * 2, 8));   // a moved-from set has capacity 0
+    }
+
+    void rehash(size_t new_cap) {
+        if constexpr (Stats::enabled) {
+            auto start = chrono::steady_clock::now();
+            rehashSlots(new_cap);
+            stats_.record_rehash(chrono::duration<double>(chrono::steady_clock::now() - start).count());
         } else {
-            static_assert(sizeof(T) == 0, "Hash not implemented for this type");
+            rehashSlots(new_cap);
         }
     }
 
-    void rehash() {
+    void rehashSlots(size_t new_cap) {
         size_t old_cap = capacity;
         Slot* old_table = table;
+        void* old_mapping = mapping;
+        size_t old_mapping_bytes = mapping_bytes;
+        mapping = nullptr;
+        mapping_bytes = 0;
 
-        capacity *= 2;
+        capacity = new_cap;
         table = new Slot[capacity];
         size_ = 0;
+        tombstones = 0;
 
-        for (size_t i = 0; i < old_cap; ++i) {
-            if (old_table[i].state == OCCUPIED) {
-                insert(old_table[i].value);
+        if (threads_ > 1 && old_cap >= PARALLEL_MIN) {
+            parallelInsert(old_cap, [&](size_t lo, size_t hi, auto&& emit) {
+                for (size_t i = lo; i < hi; ++i)
+                    if (old_table[i].state == OCCUPIED)
+                        emit(std::move(old_table[i].value));
+            });
+            if (filter.enabled()) rebuildFilter();
+        } else {
+            if (filter.enabled()) resetFilter();   // reinsertion below refills it, minus removed keys
+            for (size_t i = 0; i < old_cap; ++i) {
+                if (old_table[i].state == OCCUPIED) {
+                    insert_impl(std::move(old_table[i].value));
+                }
             }
         }
 
-        delete[] old_table;
+        freeSlots(old_table, old_mapping, old_mapping_bytes);
+    }
+
+    // ------------------ Parallel insertion ------------------
+    // Radix partition by hash prefix: the top bits of a key's home slot pick
+    // one of `parts` partitions, and partition p owns the contiguous slice
+    // [p * capacity / parts, (p + 1) * capacity / parts) of the table.
+    //   1. each thread counts the partitions of its share of the source;
+    //   2. prefix sums give every (partition, thread) pair its own range of
+    //      a staging buffer, and the threads scatter their keys into it;
+    //   3. threads claim whole partitions and insert them into their slices
+    //      with plain stores -- no two threads ever touch the same slot.
+    // A probe that would run past the end of its slice stops and the key is
+    // kept aside; those few keys are inserted serially at the end with the
+    // normal wrap-around probe. Duplicates share a partition, so they are
+    // still detected. Hashes are recomputed rather than staged: 8 bytes per
+    // key of buffer costs more than fmix64 does. The table must be empty and
+    // already large enough, and the filter (if any) is left to the caller.
+    //
+    // visit(lo, hi, emit) calls emit(key) for every key in source range
+    // [lo, hi); emit may be handed an rvalue to move from.
+    template <typename Visit>
+    void parallelInsert(size_t n, Visit visit) {
+        unsigned nt = threads_;
+        size_t parts = max<size_t>(1, min(roundUpPow2((size_t)nt * 8), capacity / 64));
+        int shift = log2Pow2(capacity) - log2Pow2(parts);
+        size_t sliceLen = capacity / parts;
+        auto partOf = [&](uint64_t h) { return (size_t)((h & (capacity - 1)) >> shift); };
+        auto forThreads = [&](auto fn) {
+            vector<thread> pool;
+            for (unsigned t = 0; t < nt; ++t) pool.emplace_back(fn, t);
+            for (auto& th : pool) th.join();
+        };
+
+        vector<size_t> counts((size_t)nt * parts, 0);
+        forThreads([&](unsigned t) {
+            size_t* mine = &counts[(size_t)t * parts];
+            visit(n * t / nt, n * (t + 1) / nt, [&](auto&& key) { ++mine[partOf(hasher(key))]; });
+        });
+
+        vector<size_t> partStart(parts + 1);
+        vector<size_t> cursor((size_t)nt * parts);
+        size_t total = 0;
+        for (size_t p = 0; p < parts; ++p) {
+            partStart[p] = total;
+            for (unsigned t = 0; t < nt; ++t) {
+                cursor[(size_t)t * parts + p] = total;
+                total += counts[(size_t)t * parts + p];
+            }
+        }
+        partStart[parts] = total;
+
+        vector<T> staged(total);
+        forThreads([&](unsigned t) {
+            size_t* mine = &cursor[(size_t)t * parts];
+            visit(n * t / nt, n * (t + 1) / nt, [&](auto&& key) {
+                staged[mine[partOf(hasher(key))]++] = std::forward<decltype(key)>(key);
+            });
+        });
+
+        atomic<size_t> nextPart{0};
+        vector<vector<T>> spill(nt);
+        vector<size_t> placed(nt, 0);
+        forThreads([&](unsigned t) {
+            for (size_t p; (p = nextPart.fetch_add(1)) < parts;) {
+                size_t sliceEnd = (p + 1) * sliceLen;
+                for (size_t i = partStart[p]; i < partStart[p + 1]; ++i) {
+                    T& key = staged[i];
+                    for (size_t idx = hasher(key) & (capacity - 1);; ++idx) {
+                        if (idx == sliceEnd) {
+                            spill[t].push_back(std::move(key));
+                            break;
+                        }
+                        if (table[idx].state == EMPTY) {
+                            table[idx].value = std::move(key);
+                            table[idx].state = OCCUPIED;
+                            ++placed[t];
+                            break;
+                        }
+                        if (table[idx].value == key)
+                            break;   // duplicate
+                    }
+                }
+            }
+        });
+
+        for (unsigned t = 0; t < nt; ++t) {
+            size_ += placed[t];
+            for (T& key : spill[t]) {
+                uint64_t h = hasher(key);
+                insertAt(std::move(key), h);
+            }
+        }
+    }
+
+    static constexpr size_t BATCH = 64;
+
+    void prefetchSlot(size_t idx) const {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&table[idx]);
+#endif
+    }
+
+    // Linear probe starting at the home slot of hash value h. The key goes
+    // into the first tombstone on its chain, but only once the walk has
+    // reached an EMPTY slot (or gone all the way round) without finding it,
+    // so reusing a tombstone never duplicates a key further down the chain.
+    template <typename K>
+    bool insertAt(K&& key, uint64_t h) {
+        size_t idx = h & (capacity - 1);
+        size_t start = idx;
+        size_t target = capacity;   // first tombstone seen, if any
+        do {
+            if (table[idx].state == EMPTY) {
+                if (target == capacity) target = idx;
+                break;
+            }
+            if (table[idx].state == OCCUPIED && table[idx].value == key)
+                return false; // duplicate
+            if (table[idx].state == DELETED && target == capacity)
+                target = idx;
+
+            idx = (idx + 1) & (capacity - 1);
+        } while (idx != start);
+
+        if (target == capacity)
+            return false; // full (should not happen after rehash)
+        if (table[target].state == DELETED)
+            --tombstones;
+        table[target].value = std::forward<K>(key);
+        table[target].state = OCCUPIED;
+        ++size_;
+        if (filter.enabled()) filter.add(h);
+        return true;
+    }
+
+    // A miss rejected by the filter is recorded with probe length 0.
+    bool findAt(const T& key, uint64_t h) const {
+        if (capacity == 0) return false;   // moved-from
+        if (filter.enabled() && !filter.may_contain(h)) {
+            stats_.record_miss(0);
+            return false;
+        }
+        size_t idx = h & (capacity - 1);
+        size_t start = idx;
+        do {
+            if (table[idx].state == EMPTY) {
+                stats_.record_miss((idx - start) & (capacity - 1));
+                return false;
+            }
+            if (table[idx].state == OCCUPIED && table[idx].value == key) {
+                stats_.record_hit((idx - start) & (capacity - 1));
+                return true;
+            }
+            idx = (idx + 1) & (capacity - 1);
+        } while (idx != start);
+        stats_.record_miss(capacity);
+        return false;
     }
 
 public:
     // --- Rule of 5 ---
-    HashSet(size_t cap = 8) : capacity(cap), size_(0) {
+    HashSet(size_t cap = 8, Hash h = Hash()) : capacity(roundUpPow2(cap)), size_(0), hasher(h) {
         table = new Slot[capacity];
     }
 
+    // Bulk build from a random-access range using `threads` threads: presized
+    // for last - first keys, then filled with parallelInsert(). The thread
+    // count is kept for later rehashes (see set_threads()).
+    template <typename It>
+    HashSet(It first, It last, unsigned threads, Hash h = Hash()) : HashSet(8, h) {
+        static_assert(is_base_of_v<random_access_iterator_tag, typename iterator_traits<It>::iterator_category>,
+                      "bulk build needs random-access iterators");
+        size_t n = last - first;
+        reserve(n);
+        threads_ = max(1u, threads);
+        if (threads_ == 1 || n < PARALLEL_MIN) {
+            for (It it = first; it != last; ++it) insert_impl(*it);
+            return;
+        }
+        parallelInsert(n, [&](size_t lo, size_t hi, auto&& emit) {
+            for (It it = first + lo; it != first + hi; ++it) emit(*it);
+        });
+    }
+
     ~HashSet() {
-        delete[] table;
+        releaseTable();
     }
 
-    HashSet(const HashSet& other) : capacity(other.capacity), size_(other.size_) {
+    HashSet(const HashSet& other)
+        : capacity(other.capacity), size_(other.size_), tombstones(other.tombstones), hasher(other.hasher),
+          filter(other.filter),
+          filter_bits_per_key(other.filter_bits_per_key), stats_(other.stats_), threads_(other.threads_) {
         table = new Slot[capacity];
         for (size_t i = 0; i < capacity; ++i)
             table[i] = other.table[i];
@@ -79,9 +488,15 @@ public:
 
     HashSet& operator=(const HashSet& other) {
         if (this != &other) {
-            delete[] table;
+            releaseTable();
             capacity = other.capacity;
             size_ = other.size_;
+            tombstones = other.tombstones;
+            hasher = other.hasher;
+            filter = other.filter;
+            filter_bits_per_key = other.filter_bits_per_key;
+            stats_ = other.stats_;
+            threads_ = other.threads_;
             table = new Slot[capacity];
             for (size_t i = 0; i < capacity; ++i)
                 table[i] = other.table[i];
@@ -90,63 +505,69 @@ public:
     }
 
     HashSet(HashSet&& other) noexcept
-        : table(other.table), capacity(other.capacity), size_(other.size_) {
+        : table(other.table), capacity(other.capacity), size_(other.size_), tombstones(other.tombstones),
+          hasher(other.hasher),
+          mapping(other.mapping), mapping_bytes(other.mapping_bytes), filter(std::move(other.filter)),
+          filter_bits_per_key(other.filter_bits_per_key), stats_(other.stats_), threads_(other.threads_) {
         other.table = nullptr;
+        other.mapping = nullptr;
+        other.mapping_bytes = 0;
         other.capacity = 0;
         other.size_ = 0;
+        other.tombstones = 0;
     }
 
     HashSet& operator=(HashSet&& other) noexcept {
         if (this != &other) {
-            delete[] table;
+            releaseTable();
             table = other.table;
             capacity = other.capacity;
             size_ = other.size_;
+            tombstones = other.tombstones;
+            hasher = other.hasher;
+            mapping = other.mapping;
+            mapping_bytes = other.mapping_bytes;
+            filter = std::move(other.filter);
+            filter_bits_per_key = other.filter_bits_per_key;
+            stats_ = other.stats_;
+            threads_ = other.threads_;
             other.table = nullptr;
+            other.mapping = nullptr;
+            other.mapping_bytes = 0;
             other.capacity = 0;
             other.size_ = 0;
+            other.tombstones = 0;
         }
         return *this;
     }
 
     // --- Required virtual methods ---
-    bool insert(T key) override {
-        if ((double)size_ / capacity > load_factor_threshold) {
-            rehash();
-        }
-
-        size_t idx = hash(key);
-        size_t start = idx;
-        do {
-            if (table[idx].state == EMPTY || table[idx].state == DELETED) {
-                table[idx].value = key;
-                table[idx].state = OCCUPIED;
-                ++size_;
-                return true;
-            }
-            if (table[idx].state == OCCUPIED && table[idx].value == key)
-                return false; // duplicate
-
-            idx = (idx + 1) % capacity;
-        } while (idx != start);
+    bool insert(T key) override { return insert_impl(std::move(key)); }
+    bool find(T key) const override { return find_impl(key); }
+    void remove(T key) override { remove_impl(key); }
 
-        return false; // full (should not happen after rehash)
+    // --- StaticSet implementation (keys by reference) ---
+    // Tombstones lengthen probes like keys, so they count toward the load
+    // threshold. When most of that load is tombstones, the table is rebuilt
+    // at the same capacity, which sweeps them, instead of doubling.
+    template <typename K>
+    bool insert_impl(K&& key) {
+        if (capacity == 0 || (double)(size_ + tombstones) / capacity > load_factor_threshold) {
+            if (capacity == 0 || (double)size_ / capacity > load_factor_threshold / 2)
+                rehash();
+            else
+                rehash(capacity);
+        }
+        uint64_t h = hasher(key);
+        return insertAt(std::forward<K>(key), h);
     }
 
-    bool find(T key) const override {
-        size_t idx = hash(key);
-        size_t start = idx;
-        do {
-            if (table[idx].state == EMPTY)
-                return false;
-            if (table[idx].state == OCCUPIED && table[idx].value == key)
-                return true;
-            idx = (idx + 1) % capacity;
-        } while (idx != start);
-        return false;
+    bool find_impl(const T& key) const {
+        return findAt(key, hasher(key));
     }
 
-    void remove(T key) override {
+    void remove_impl(const T& key) {
+        if (capacity == 0) return;
         size_t idx = hash(key);
         size_t start = idx;
         do {
@@ -155,12 +576,256 @@ public:
             if (table[idx].state == OCCUPIED && table[idx].value == key) {
                 table[idx].state = DELETED;
                 --size_;
+                ++tombstones;
                 return;
             }
-            idx = (idx + 1) % capacity;
+            idx = (idx + 1) & (capacity - 1);
         } while (idx != start);
     }
 
+    // Grow now so that n keys fit without crossing the load factor.
+    void reserve(size_t n) {
+        size_t cap = max<size_t>(capacity, 8);   // a moved-from set has capacity 0
+        while ((double)(n + tombstones) / cap > load_factor_threshold) cap *= 2;
+        if (cap != capacity) rehash(cap);
+    }
+
+    // ------------------ Batched operations ------------------
+    // Process keys in windows of 64: hash the whole window and prefetch every
+    // home slot first, then resolve the probes. The cache misses of up to 64
+    // independent lookups overlap, instead of each find() waiting on its own.
+    // With the filter enabled the window is prefetched in two rounds: filter
+    // blocks first, then only the slots of keys the filter did not reject.
+    // Bit i of out_bits (word i / 64, bit i % 64) is set iff keys[i] is present.
+    void find_many(const vector<T>& keys, vector<uint64_t>& out_bits) const {
+        out_bits.assign((keys.size() + BATCH - 1) / BATCH, 0);
+        uint64_t hv[BATCH];
+        for (size_t base = 0; base < keys.size(); base += BATCH) {
+            size_t count = min(BATCH, keys.size() - base);
+            uint64_t maybe = count == 64 ? ~0ULL : (1ULL << count) - 1;
+            for (size_t j = 0; j < count; ++j) {
+                hv[j] = hasher(keys[base + j]);
+                if (filter.enabled()) filter.prefetch(hv[j]);
+                else prefetchSlot(hv[j] & (capacity - 1));
+            }
+            if (filter.enabled()) {
+                for (size_t j = 0; j < count; ++j) {
+                    if (filter.may_contain(hv[j])) prefetchSlot(hv[j] & (capacity - 1));
+                    else maybe &= ~(1ULL << j);
+                }
+            }
+            uint64_t bits = 0;
+            for (size_t j = 0; j < count; ++j)
+                if (maybe >> j & 1)
+                    bits |= (uint64_t)findAt(keys[base + j], hv[j]) << j;
+            out_bits[base / BATCH] = bits;
+        }
+    }
+
+    // Batched insert; returns how many keys were new. The table is grown for
+    // the whole batch up front, so the precomputed home slots stay valid.
+    size_t insert_many(const vector<T>& keys) {
+        reserve(size_ + keys.size());
+        size_t added = 0;
+        uint64_t hv[BATCH];
+        for (size_t base = 0; base < keys.size(); base += BATCH) {
+            size_t count = min(BATCH, keys.size() - base);
+            for (size_t j = 0; j < count; ++j) {
+                hv[j] = hasher(keys[base + j]);
+                prefetchSlot(hv[j] & (capacity - 1));
+            }
+            for (size_t j = 0; j < count; ++j)
+                added += insertAt(keys[base + j], hv[j]);
+        }
+        return added;
+    }
+
+    // ------------------ Bloom filter front-end ------------------
+    // Optional filter consulted before probing: a key it rejects is a miss
+    // after reading one cache line, with no walk to an EMPTY slot. insert()
+    // adds keys to it. remove() cannot clear bits, so removed keys make it
+    // staler (more false positives, never false negatives) until the next
+    // rehash, which rebuilds it from the live keys. The filter is sized for a
+    // full table; bits_per_key ~12 gives well under 1% false positives.
+    // It is not part of snapshots -- call enable_filter() after load().
+    void enable_filter(double bits_per_key = 12) {
+        filter_bits_per_key = bits_per_key;
+        rebuildFilter();
+    }
+
+    void disable_filter() {
+        filter.reset(0, 0);
+        filter_bits_per_key = 0;
+    }
+
+    // False for keys the filter proves absent; true if disabled.
+    bool filter_may_contain(const T& key) const {
+        return !filter.enabled() || filter.may_contain(hasher(key));
+    }
+
+    size_t filter_bytes() const { return filter.memory_bytes(); }
+
+    // Threads used by rehash() once the table has PARALLEL_MIN slots.
+    void set_threads(unsigned threads) { threads_ = max(1u, threads); }
+
+    size_t size() const { return size_; }
+
+    size_t memory_bytes() const { return capacity * sizeof(Slot); }
+
+    double load_factor() const { return capacity ? (double)size_ / capacity : 0.0; }
+
+    // Longest and average distance of stored keys from their home slot.
+    size_t max_probe() const {
+        size_t longest = 0;
+        for (size_t i = 0; i < capacity; ++i)
+            if (table[i].state == OCCUPIED)
+                longest = max(longest, (i - hash(table[i].value)) & (capacity - 1));
+        return longest;
+    }
+
+    double avg_probe() const {
+        size_t total = 0;
+        for (size_t i = 0; i < capacity; ++i)
+            if (table[i].state == OCCUPIED)
+                total += (i - hash(table[i].value)) & (capacity - 1);
+        return size_ ? (double)total / size_ : 0.0;
+    }
+
+    // ------------------ Statistics ------------------
+    const Stats& stats() const { return stats_; }
+
+    void reset_stats() { stats_.reset(); }
+
+    // One-line JSON object: the table's shape, computed by a scan, followed
+    // by whatever counters the Stats policy keeps (none for NoStats).
+    // tombstone_ratio is DELETED slots / capacity; max_cluster is the longest
+    // run of non-EMPTY slots, which bounds the probe length of any miss.
+    string stats_json() const {
+        size_t longest = 0;
+        size_t firstEmpty = 0;
+        while (firstEmpty < capacity && table[firstEmpty].state != EMPTY) ++firstEmpty;
+        if (firstEmpty == capacity) {
+            longest = capacity;
+        } else {
+            // Start after an EMPTY slot so a cluster wrapping past the end is measured whole.
+            size_t run = 0;
+            for (size_t k = 1; k <= capacity; ++k) {
+                size_t i = (firstEmpty + k) & (capacity - 1);
+                run = table[i].state == EMPTY ? 0 : run + 1;
+                longest = max(longest, run);
+            }
+        }
+        string out = "{\"size\":" + to_string(size_);
+        out += ",\"capacity\":" + to_string(capacity);
+        out += ",\"load_factor\":" + to_string(load_factor());
+        out += ",\"tombstones\":" + to_string(tombstones);
+        out += ",\"tombstone_ratio\":" + to_string(capacity ? (double)tombstones / capacity : 0.0);
+        out += ",\"max_cluster\":" + to_string(longest);
+        stats_.append_json(out);
+        return out + "}";
+    }
+
+    // ------------------ Snapshots ------------------
+    // save() writes the header and then the slot array exactly as it is in
+    // memory: capacity, hasher state and slot states included. load() maps
+    // the file copy-on-write (MAP_PRIVATE) and uses the array in place, with
+    // no inserts and no rehash. Pages are shared with the page cache until
+    // written, and the first insert/remove that touches a page copies just
+    // that page. Only the header checksum is checked by default; pass
+    // verify_data to also checksum the slot array (reads the whole file).
+    // The format is native-endian and limited to trivially copyable T.
+    // Slots are written with padding and the values of EMPTY/DELETED slots
+    // zeroed, so equal tables give byte-identical snapshots.
+    void save(const string& path) const {
+        static_assert(is_trivially_copyable_v<T>, "snapshots need trivially copyable keys");
+        static_assert(is_trivially_copyable_v<Hash> && sizeof(Hash) <= 16,
+                      "hasher state must fit the snapshot header");
+        ofstream out(path, ios::binary | ios::trunc);
+        if (!out) throw runtime_error("cannot create snapshot " + path);
+        vector<char> page(SNAPSHOT_DATA_OFFSET, 0);
+        out.write(page.data(), page.size());   // header goes here once the data checksum is known
+
+        constexpr size_t CHUNK = 512;           // slots per write; CHUNK * sizeof(Slot) is a multiple of 8
+        vector<char> buf(CHUNK * sizeof(Slot));
+        uint64_t sum = 0x9E3779B97F4A7C15ULL ^ (capacity * sizeof(Slot));
+        for (size_t first = 0; first < capacity; first += CHUNK) {
+            size_t count = min(CHUNK, capacity - first);
+            fill(buf.begin(), buf.end(), 0);
+            for (size_t i = 0; i < count; ++i) {
+                const Slot& slot = table[first + i];
+                char* dst = buf.data() + i * sizeof(Slot);
+                memcpy(dst + offsetof(Slot, state), &slot.state, sizeof slot.state);
+                if (slot.state == OCCUPIED) memcpy(dst + offsetof(Slot, value), &slot.value, sizeof(T));
+            }
+            sum = checksumStep(sum, buf.data(), count * sizeof(Slot));
+            out.write(buf.data(), count * sizeof(Slot));
+        }
+
+        SnapshotHeader hdr{};
+        memcpy(hdr.magic, SNAPSHOT_MAGIC, sizeof hdr.magic);
+        hdr.version = SNAPSHOT_VERSION;
+        hdr.slot_bytes = sizeof(Slot);
+        hdr.capacity = capacity;
+        hdr.size = size_;
+        hdr.tombstones = tombstones;
+        memcpy(hdr.hash_state, &hasher, sizeof(Hash));
+        hdr.data_checksum = sum;
+        hdr.header_checksum = checksum(&hdr, offsetof(SnapshotHeader, header_checksum));
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&hdr), sizeof hdr);
+        if (!out) throw runtime_error("cannot write snapshot " + path);
+    }
+
+    static HashSet load(const string& path, bool verify_data = false) {
+        static_assert(is_trivially_copyable_v<T>, "snapshots need trivially copyable keys");
+        static_assert(is_trivially_copyable_v<Hash> && sizeof(Hash) <= 16,
+                      "hasher state must fit the snapshot header");
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw runtime_error("cannot open snapshot " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < SNAPSHOT_DATA_OFFSET) {
+            close(fd);
+            throw runtime_error("snapshot too short: " + path);
+        }
+        size_t bytes = st.st_size;
+        void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) throw runtime_error("cannot map snapshot " + path);
+
+        auto reject = [&](const string& why) {
+            munmap(base, bytes);
+            return runtime_error("bad snapshot " + path + ": " + why);
+        };
+        SnapshotHeader hdr;
+        memcpy(&hdr, base, sizeof hdr);
+        if (memcmp(hdr.magic, SNAPSHOT_MAGIC, sizeof hdr.magic) != 0) throw reject("not a HashSet snapshot");
+        if (hdr.version != SNAPSHOT_VERSION) throw reject("unsupported version " + to_string(hdr.version));
+        if (hdr.header_checksum != checksum(&hdr, offsetof(SnapshotHeader, header_checksum)))
+            throw reject("header checksum mismatch");
+        if (hdr.slot_bytes != sizeof(Slot)) throw reject("slot size differs (different key type?)");
+        if (hdr.capacity == 0 || (hdr.capacity & (hdr.capacity - 1)) != 0)
+            throw reject("capacity is not a power of two");
+        if (hdr.capacity > (bytes - SNAPSHOT_DATA_OFFSET) / sizeof(Slot)) throw reject("truncated slot array");
+        if (hdr.size > hdr.capacity || hdr.tombstones > hdr.capacity - hdr.size)
+            throw reject("size and tombstones exceed capacity");
+
+        Slot* slots = reinterpret_cast<Slot*>(static_cast<char*>(base) + SNAPSHOT_DATA_OFFSET);
+        if (verify_data && checksum(slots, hdr.capacity * sizeof(Slot)) != hdr.data_checksum)
+            throw reject("data checksum mismatch");
+
+        Hash h;
+        memcpy(&h, hdr.hash_state, sizeof(Hash));
+        HashSet s(1, h);
+        s.releaseTable();
+        s.table = slots;
+        s.capacity = hdr.capacity;
+        s.size_ = hdr.size;
+        s.tombstones = hdr.tombstones;
+        s.mapping = base;
+        s.mapping_bytes = bytes;
+        return s;
+    }
+
     void print() const {
         cout << "{ ";
         for (size_t i = 0; i < capacity; ++i) {
@@ -171,31 +836,2124 @@ public:
     }
 };
 
-int main() {
-    HashSet<int> s;
-    s.insert(10);
-    s.insert(20);
-    s.insert(30);
-    s.insert(20); // duplicate ignored
+// Swiss-table style Set: the per-slot state lives in a separate array of
+// 1-byte control tags instead of next to each value.
+//   ctrl[i] = EMPTY (0x80), DELETED (0xFE), or the low 7 bits of hash (full).
+// The table is split into aligned groups of 16 tags. A probe loads a whole
+// group and compares all 16 tags with the key's 7-bit tag in one SSE2
+// instruction, so a lookup usually needs one vector compare and one key
+// comparison; it stops at the first group that still has an EMPTY tag.
+template <typename T, typename Hash = SetHash<T>>
+class SwissHashSet : public Set<T>, public StaticSet<SwissHashSet<T, Hash>, T> {
+private:
+    static constexpr size_t GROUP = 16;
+    static constexpr int8_t EMPTY = -128;   // 0b10000000
+    static constexpr int8_t DELETED = -2;   // 0b11111110
 
-    s.print();
+    int8_t* ctrl;
+    T* slots;
+    size_t capacity;      // power of two, multiple of GROUP
+    size_t size_;
+    size_t growth_left;   // EMPTY slots we may still fill before rehashing (7/8 max load)
 
-    cout << "Find 10: " << s.find(10) << endl;
-    cout << "Find 25: " << s.find(25) << endl;
+    Hash hasher;
 
-    s.remove(10);
-    s.print();
+    uint64_t hash(const T& key) const { return hasher(key); }
 
-    // Test copy constructor
-    HashSet<int> copy = s;
-    copy.insert(40);
-    cout << "Copy: ";
-    copy.print();
+    static int8_t tagOf(uint64_t h) { return static_cast<int8_t>(h & 0x7F); }
+    size_t groupMask() const { return capacity / GROUP - 1; }
 
-    // Test move constructor
-    HashSet<int> moved = std::move(copy);
-    cout << "Moved: ";
-    moved.print();
+    // Bitmask of positions in group g whose tag equals `tag`.
+    uint32_t match(size_t g, int8_t tag) const {
+#ifdef __SSE2__
+        __m128i ctrlVec = _mm_load_si128(reinterpret_cast<const __m128i*>(ctrl + g * GROUP));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrlVec, _mm_set1_epi8(tag))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP; ++i)
+            if (ctrl[g * GROUP + i] == tag) mask |= 1u << i;
+        return mask;
+#endif
+    }
+
+    // Bitmask of EMPTY or DELETED positions in group g (tags below -1).
+    uint32_t matchFree(size_t g) const {
+#ifdef __SSE2__
+        __m128i ctrlVec = _mm_load_si128(reinterpret_cast<const __m128i*>(ctrl + g * GROUP));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrlVec)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP; ++i)
+            if (ctrl[g * GROUP + i] < -1) mask |= 1u << i;
+        return mask;
+#endif
+    }
+
+    static int lowestBit(uint32_t mask) { return __builtin_ctz(mask); }
+
+    void allocate(size_t cap) {
+        capacity = cap < GROUP ? GROUP : cap;
+        ctrl = static_cast<int8_t*>(::operator new(capacity, align_val_t(GROUP)));
+        memset(ctrl, EMPTY, capacity);
+        slots = new T[capacity];
+        size_ = 0;
+        growth_left = capacity - capacity / 8;
+    }
+
+    void release() {
+        if (ctrl) ::operator delete(ctrl, align_val_t(GROUP));
+        delete[] slots;
+        ctrl = nullptr;
+        slots = nullptr;
+    }
+
+    // Slot index of key, or capacity if absent.
+    size_t locate(const T& key, uint64_t h) const {
+        int8_t tag = tagOf(h);
+        size_t g = (h >> 7) & groupMask();
+        for (size_t step = 1; ; ++step) {
+            for (uint32_t m = match(g, tag); m; m &= m - 1) {
+                size_t idx = g * GROUP + lowestBit(m);
+                if (slots[idx] == key) return idx;
+            }
+            if (match(g, EMPTY)) return capacity;
+            if (step > groupMask()) return capacity;   // visited every group
+            g = (g + step) & groupMask();               // triangular probing
+        }
+    }
+
+    // First EMPTY or DELETED slot on key's probe sequence.
+    size_t findFree(uint64_t h) const {
+        size_t g = (h >> 7) & groupMask();
+        for (size_t step = 1; ; ++step) {
+            if (uint32_t m = matchFree(g)) return g * GROUP + lowestBit(m);
+            g = (g + step) & groupMask();
+        }
+    }
+
+    void rehash(size_t new_cap) {
+        int8_t* old_ctrl = ctrl;
+        T* old_slots = slots;
+        size_t old_cap = capacity;
+
+        allocate(new_cap);
+        for (size_t i = 0; i < old_cap; ++i) {
+            if (old_ctrl[i] >= 0) {
+                uint64_t h = hash(old_slots[i]);
+                size_t idx = findFree(h);
+                ctrl[idx] = tagOf(h);
+                slots[idx] = std::move(old_slots[i]);
+                ++size_;
+                --growth_left;
+            }
+        }
+
+        ::operator delete(old_ctrl, align_val_t(GROUP));
+        delete[] old_slots;
+    }
+
+public:
+    // --- Rule of 5 ---
+    SwissHashSet(size_t cap = 16, Hash h = Hash()) : hasher(h) {
+        size_t c = GROUP;
+        while (c < cap) c *= 2;
+        allocate(c);
+    }
+
+    ~SwissHashSet() {
+        release();
+    }
+
+    SwissHashSet(const SwissHashSet& other)
+        : ctrl(nullptr), slots(nullptr), capacity(0), size_(0), growth_left(0), hasher(other.hasher) {
+        if (other.capacity == 0) return;   // moved-from: the copy is moved-from-empty too
+        allocate(other.capacity);
+        memcpy(ctrl, other.ctrl, capacity);
+        for (size_t i = 0; i < capacity; ++i)
+            slots[i] = other.slots[i];
+        size_ = other.size_;
+        growth_left = other.growth_left;
+    }
+
+    SwissHashSet& operator=(const SwissHashSet& other) {
+        if (this != &other) {
+            SwissHashSet copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    SwissHashSet(SwissHashSet&& other) noexcept
+        : ctrl(other.ctrl), slots(other.slots), capacity(other.capacity),
+          size_(other.size_), growth_left(other.growth_left), hasher(other.hasher) {
+        other.ctrl = nullptr;
+        other.slots = nullptr;
+        other.capacity = 0;
+        other.size_ = 0;
+        other.growth_left = 0;
+    }
+
+    SwissHashSet& operator=(SwissHashSet&& other) noexcept {
+        if (this != &other) {
+            release();
+            ctrl = other.ctrl;
+            slots = other.slots;
+            capacity = other.capacity;
+            size_ = other.size_;
+            growth_left = other.growth_left;
+            hasher = other.hasher;
+            other.ctrl = nullptr;
+            other.slots = nullptr;
+            other.capacity = 0;
+            other.size_ = 0;
+            other.growth_left = 0;
+        }
+        return *this;
+    }
+
+    // --- Required virtual methods ---
+    bool insert(T key) override { return insert_impl(std::move(key)); }
+    bool find(T key) const override { return find_impl(key); }
+    void remove(T key) override { remove_impl(key); }
+
+    // --- StaticSet implementation (keys by reference) ---
+    template <typename K>
+    bool insert_impl(K&& key) {
+        if (capacity == 0) allocate(GROUP);
+        uint64_t h = hash(key);
+        if (locate(key, h) != capacity)
+            return false; // duplicate
+
+        size_t idx = findFree(h);
+        if (ctrl[idx] == EMPTY && growth_left == 0) {
+            // Out of EMPTY slots: grow, or just purge tombstones if the
+            // table is mostly DELETED.
+            rehash(size_ * 2 >= capacity * 7 / 8 ? capacity * 2 : capacity);
+            idx = findFree(h);
+        }
+        if (ctrl[idx] == EMPTY) --growth_left;
+        ctrl[idx] = tagOf(h);
+        slots[idx] = std::forward<K>(key);
+        ++size_;
+        return true;
+    }
+
+    bool find_impl(const T& key) const {
+        if (capacity == 0) return false;
+        return locate(key, hash(key)) != capacity;
+    }
+
+    void remove_impl(const T& key) {
+        if (capacity == 0) return;
+        size_t idx = locate(key, hash(key));
+        if (idx == capacity) return;
+
+        // A group that still has an EMPTY tag ends every probe that reaches
+        // it, so the slot can become EMPTY again instead of a tombstone.
+        if (match(idx / GROUP, EMPTY)) {
+            ctrl[idx] = EMPTY;
+            ++growth_left;
+        } else {
+            ctrl[idx] = DELETED;
+        }
+        --size_;
+    }
+
+    size_t size() const { return size_; }
+
+    void print() const {
+        cout << "{ ";
+        for (size_t i = 0; i < capacity; ++i) {
+            if (ctrl[i] >= 0)
+                cout << slots[i] << " ";
+        }
+        cout << "}" << endl;
+    }
+};
+
+// Robin Hood hashing: linear probing where every slot remembers its
+// distance from its home slot. An insert that meets an entry closer to
+// home than itself takes the slot and carries the evicted entry on.
+// This keeps probe lengths short and even. A lookup can stop once it sees
+// an entry closer to home than the key would be. remove() uses
+// backward-shift deletion: later entries in the cluster move back one slot.
+// No tombstones are ever left, so churn cannot degrade lookups.
+template <typename T, typename Hash = SetHash<T>>
+class RobinHoodHashSet : public Set<T>, public StaticSet<RobinHoodHashSet<T, Hash>, T> {
+private:
+    struct Slot {
+        T value;
+        int32_t dist;     // probe distance from home slot, -1 = empty
+        Slot() : dist(-1) {}
+    };
+
+    Slot* table;
+    size_t capacity;      // power of two
+    size_t size_;
+    static constexpr double load_factor_threshold = 0.85;
+
+    Hash hasher;
+
+    size_t home(const T& key) const { return hasher(key) & (capacity - 1); }
+
+    void place(T key) {
+        size_t idx = home(key);
+        int32_t dist = 0;
+        while (true) {
+            if (table[idx].dist < 0) {
+                table[idx].value = std::move(key);
+                table[idx].dist = dist;
+                ++size_;
+                return;
+            }
+            if (table[idx].dist < dist) {
+                // Rob the richer entry and keep probing on its behalf.
+                swap(key, table[idx].value);
+                swap(dist, table[idx].dist);
+            }
+            idx = (idx + 1) & (capacity - 1);
+            ++dist;
+        }
+    }
+
+    // Slot index of key, or capacity if absent.
+    size_t locate(const T& key) const {
+        size_t idx = home(key);
+        for (int32_t dist = 0; ; ++dist) {
+            if (table[idx].dist < dist)   // empty, or an entry closer to home
+                return capacity;
+            if (table[idx].value == key)
+                return idx;
+            idx = (idx + 1) & (capacity - 1);
+        }
+    }
+
+    void rehash() {
+        size_t old_cap = capacity;
+        Slot* old_table = table;
+
+        capacity *= 2;
+        table = new Slot[capacity];
+        size_ = 0;
+
+        for (size_t i = 0; i < old_cap; ++i) {
+            if (old_table[i].dist >= 0) {
+                place(std::move(old_table[i].value));
+            }
+        }
+
+        delete[] old_table;
+    }
+
+public:
+    // --- Rule of 5 ---
+    RobinHoodHashSet(size_t cap = 8, Hash h = Hash()) : size_(0), hasher(h) {
+        capacity = 8;
+        while (capacity < cap) capacity *= 2;
+        table = new Slot[capacity];
+    }
+
+    ~RobinHoodHashSet() {
+        delete[] table;
+    }
+
+    RobinHoodHashSet(const RobinHoodHashSet& other)
+        : capacity(other.capacity), size_(other.size_), hasher(other.hasher) {
+        table = new Slot[capacity];
+        for (size_t i = 0; i < capacity; ++i)
+            table[i] = other.table[i];
+    }
+
+    RobinHoodHashSet& operator=(const RobinHoodHashSet& other) {
+        if (this != &other) {
+            delete[] table;
+            capacity = other.capacity;
+            size_ = other.size_;
+            hasher = other.hasher;
+            table = new Slot[capacity];
+            for (size_t i = 0; i < capacity; ++i)
+                table[i] = other.table[i];
+        }
+        return *this;
+    }
+
+    RobinHoodHashSet(RobinHoodHashSet&& other) noexcept
+        : table(other.table), capacity(other.capacity), size_(other.size_), hasher(other.hasher) {
+        other.table = nullptr;
+        other.capacity = 0;
+        other.size_ = 0;
+    }
+
+    RobinHoodHashSet& operator=(RobinHoodHashSet&& other) noexcept {
+        if (this != &other) {
+            delete[] table;
+            table = other.table;
+            capacity = other.capacity;
+            size_ = other.size_;
+            hasher = other.hasher;
+            other.table = nullptr;
+            other.capacity = 0;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    // --- Required virtual methods ---
+    bool insert(T key) override { return insert_impl(std::move(key)); }
+    bool find(T key) const override { return find_impl(key); }
+    void remove(T key) override { remove_impl(key); }
+
+    // --- StaticSet implementation (keys by reference) ---
+    template <typename K>
+    bool insert_impl(K&& key) {
+        if (capacity == 0) {
+            capacity = 8;
+            table = new Slot[capacity];
+        }
+        if (locate(key) != capacity)
+            return false; // duplicate
+        if ((double)(size_ + 1) / capacity > load_factor_threshold) {
+            rehash();
+        }
+        place(std::forward<K>(key));
+        return true;
+    }
+
+    bool find_impl(const T& key) const {
+        return capacity != 0 && locate(key) != capacity;
+    }
+
+    void remove_impl(const T& key) {
+        if (capacity == 0) return;
+        size_t idx = locate(key);
+        if (idx == capacity) return;
+
+        // Backward shift: pull the rest of the cluster one slot closer to
+        // home until an empty slot or an entry already at its home.
+        size_t next = (idx + 1) & (capacity - 1);
+        while (table[next].dist > 0) {
+            table[idx].value = std::move(table[next].value);
+            table[idx].dist = table[next].dist - 1;
+            idx = next;
+            next = (next + 1) & (capacity - 1);
+        }
+        table[idx].dist = -1;
+        --size_;
+    }
+
+    size_t size() const { return size_; }
+
+    // Longest and average probe distance over all stored keys.
+    size_t max_probe() const {
+        int32_t longest = 0;
+        for (size_t i = 0; i < capacity; ++i)
+            longest = max(longest, table[i].dist);
+        return longest;
+    }
+
+    double avg_probe() const {
+        size_t total = 0;
+        for (size_t i = 0; i < capacity; ++i)
+            if (table[i].dist >= 0) total += table[i].dist;
+        return size_ ? (double)total / size_ : 0.0;
+    }
+
+    void print() const {
+        cout << "{ ";
+        for (size_t i = 0; i < capacity; ++i) {
+            if (table[i].dist >= 0)
+                cout << table[i].value << " ";
+        }
+        cout << "}" << endl;
+    }
+};
+
+// HashSet with incremental (amortized) resizing. Crossing the load factor
+// does not rehash everything at once. Instead, a table twice as large (or
+// the same size, when the load is mostly tombstones) is allocated and the
+// old table is kept alive while its entries migrate.
+// Each later insert/remove moves at most MIGRATE_STEP old slots, and
+// find() checks both tables until the migration is done. The worst-case
+// insert is then O(MIGRATE_STEP) slot moves plus one allocation instead of
+// O(n). With MIGRATE_STEP = 8 the old table is drained long before the new
+// one can reach its own threshold. (Freeing a drained multi-MB table is
+// still one munmap, which now dominates the worst case.)
+template <typename T, typename Hash = SetHash<T>>
+class IncrementalHashSet : public Set<T>, public StaticSet<IncrementalHashSet<T, Hash>, T> {
+private:
+    enum SlotState { EMPTY, OCCUPIED, DELETED };
+
+    struct Slot {
+        T value;
+        SlotState state;
+        Slot() : state(EMPTY) {}
+    };
+
+    struct Table {
+        Slot* slots = nullptr;
+        size_t capacity = 0;      // power of two
+        size_t size = 0;
+        size_t tombstones = 0;    // DELETED slots left by remove()
+    };
+
+    Table cur;                    // receives all new inserts
+    Table old;                    // being drained; old.slots == nullptr when idle
+    size_t cursor = 0;            // next old slot to migrate
+    Hash hasher;
+    static constexpr double load_factor_threshold = 0.6;
+    static constexpr size_t MIGRATE_STEP = 8;
+
+    // Slot index of key in t, or t.capacity if absent.
+    size_t locate(const Table& t, const T& key) const {
+        size_t mask = t.capacity - 1;
+        size_t idx = hasher(key) & mask;
+        for (size_t i = 0; i < t.capacity; ++i) {
+            if (t.slots[idx].state == EMPTY)
+                return t.capacity;
+            if (t.slots[idx].state == OCCUPIED && t.slots[idx].value == key)
+                return idx;
+            idx = (idx + 1) & mask;
+        }
+        return t.capacity;
+    }
+
+    // Insert a key known to be absent from t, reusing the first tombstone.
+    void place(Table& t, T key) {
+        size_t mask = t.capacity - 1;
+        size_t idx = hasher(key) & mask;
+        while (t.slots[idx].state == OCCUPIED)
+            idx = (idx + 1) & mask;
+        if (t.slots[idx].state == DELETED)
+            --t.tombstones;
+        t.slots[idx].value = std::move(key);
+        t.slots[idx].state = OCCUPIED;
+        ++t.size;
+    }
+
+    // For trivial T the new table comes from calloc: large blocks are fresh
+    // zero pages (EMPTY == 0), so growing does not touch n slots up front.
+    static Slot* allocSlots(size_t cap) {
+        if constexpr (is_trivially_default_constructible_v<T> && is_trivially_destructible_v<T>) {
+            return static_cast<Slot*>(calloc(cap, sizeof(Slot)));
+        } else {
+            return new Slot[cap];
+        }
+    }
+
+    static void freeSlots(Slot* slots) {
+        if constexpr (is_trivially_default_constructible_v<T> && is_trivially_destructible_v<T>) {
+            free(slots);
+        } else {
+            delete[] slots;
+        }
+    }
+
+    bool migrating() const { return old.slots != nullptr; }
+
+    // Move up to `budget` old slots into cur.
+    void migrate(size_t budget) {
+        while (migrating() && budget--) {
+            Slot& s = old.slots[cursor];
+            if (s.state == OCCUPIED) {
+                place(cur, std::move(s.value));
+                // Leave a tombstone so probe chains through this slot stay intact.
+                s.state = DELETED;
+                --old.size;
+            }
+            if (++cursor == old.capacity) {
+                freeSlots(old.slots);
+                old = Table();
+            }
+        }
+    }
+
+    void startMigration(size_t new_cap) {
+        if (migrating()) migrate(old.capacity);   // should not happen; see class comment
+        old = cur;
+        cur.capacity = new_cap;
+        cur.slots = allocSlots(cur.capacity);
+        cur.size = 0;
+        cur.tombstones = 0;
+        cursor = 0;
+    }
+
+public:
+    // --- Rule of 5 ---
+    IncrementalHashSet(size_t cap = 8, Hash h = Hash()) : hasher(h) {
+        cur.capacity = 8;
+        while (cur.capacity < cap) cur.capacity *= 2;
+        cur.slots = allocSlots(cur.capacity);
+    }
+
+    ~IncrementalHashSet() {
+        freeSlots(cur.slots);
+        freeSlots(old.slots);
+    }
+
+    IncrementalHashSet(const IncrementalHashSet& other) : hasher(other.hasher) {
+        if (other.cur.capacity == 0) return;   // moved-from: insert_impl() allocates on first use
+        // The copy starts out fully migrated.
+        cur.capacity = other.cur.capacity;
+        cur.slots = allocSlots(cur.capacity);
+        for (const Table* t : {&other.cur, &other.old})
+            for (size_t i = 0; i < t->capacity; ++i)
+                if (t->slots[i].state == OCCUPIED) place(cur, t->slots[i].value);
+    }
+
+    IncrementalHashSet& operator=(const IncrementalHashSet& other) {
+        if (this != &other) {
+            IncrementalHashSet copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    IncrementalHashSet(IncrementalHashSet&& other) noexcept
+        : cur(other.cur), old(other.old), cursor(other.cursor), hasher(other.hasher) {
+        other.cur = Table();
+        other.old = Table();
+    }
+
+    IncrementalHashSet& operator=(IncrementalHashSet&& other) noexcept {
+        if (this != &other) {
+            freeSlots(cur.slots);
+            freeSlots(old.slots);
+            cur = other.cur;
+            old = other.old;
+            cursor = other.cursor;
+            hasher = other.hasher;
+            other.cur = Table();
+            other.old = Table();
+        }
+        return *this;
+    }
+
+    // --- Required virtual methods ---
+    bool insert(T key) override { return insert_impl(std::move(key)); }
+    bool find(T key) const override { return find_impl(key); }
+    void remove(T key) override { remove_impl(key); }
+
+    // --- StaticSet implementation (keys by reference) ---
+    template <typename K>
+    bool insert_impl(K&& key) {
+        if (cur.capacity == 0) {
+            cur.capacity = 8;
+            cur.slots = allocSlots(cur.capacity);
+        }
+        migrate(MIGRATE_STEP);
+        if (locate(cur, key) != cur.capacity)
+            return false; // duplicate
+        if (migrating() && locate(old, key) != old.capacity)
+            return false; // duplicate, not migrated yet
+
+        // Tombstones lengthen probes like keys, so they count toward the
+        // threshold. When most of that load is tombstones, migrate into a
+        // table of the same size, which leaves them behind.
+        if ((double)(cur.size + cur.tombstones + 1) / cur.capacity > load_factor_threshold) {
+            bool grow = (double)(cur.size + 1) / cur.capacity > load_factor_threshold / 2;
+            startMigration(grow ? cur.capacity * 2 : cur.capacity);
+            migrate(MIGRATE_STEP);
+        }
+        place(cur, std::forward<K>(key));
+        return true;
+    }
+
+    bool find_impl(const T& key) const {
+        if (cur.capacity == 0) return false;
+        if (locate(cur, key) != cur.capacity) return true;
+        return migrating() && locate(old, key) != old.capacity;
+    }
+
+    void remove_impl(const T& key) {
+        if (cur.capacity == 0) return;
+        migrate(MIGRATE_STEP);
+        size_t idx = locate(cur, key);
+        if (idx != cur.capacity) {
+            cur.slots[idx].state = DELETED;
+            --cur.size;
+            ++cur.tombstones;
+            return;
+        }
+        if (migrating() && (idx = locate(old, key)) != old.capacity) {
+            old.slots[idx].state = DELETED;
+            --old.size;
+        }
+    }
+
+    size_t size() const { return cur.size + old.size; }
+
+    void print() const {
+        cout << "{ ";
+        for (const Table* t : {&cur, &old})
+            for (size_t i = 0; i < t->capacity; ++i)
+                if (t->slots[i].state == OCCUPIED)
+                    cout << t->slots[i].value << " ";
+        cout << "}" << endl;
+    }
+};
+
+// Open-addressing Set for integer keys with no per-slot state: two key
+// values are reserved as sentinels,
+//   EMPTY_KEY = max(), TOMBSTONE = max() - 1,
+// so the table is a flat array of keys. For HashSet<int> each Slot is an
+// int plus a padded 4-byte enum (8 bytes); here a slot is 4 bytes, which
+// halves memory and fits 16 keys per cache line instead of 8. The two
+// sentinel values themselves can still be stored: they are tracked by two
+// flags outside the table.
+template <typename T, typename Hash = SetHash<T>>
+class FlatHashSet : public Set<T>, public StaticSet<FlatHashSet<T, Hash>, T> {
+    static_assert(is_integral_v<T>, "FlatHashSet reserves integer sentinel keys");
+
+private:
+    static constexpr T EMPTY_KEY = numeric_limits<T>::max();
+    static constexpr T TOMBSTONE = numeric_limits<T>::max() - 1;
+    static constexpr double load_factor_threshold = 0.6;
+
+    T* table;
+    size_t capacity;          // power of two
+    size_t size_;             // keys in the table (sentinel keys not included)
+    size_t tombstones;
+    bool hasEmptyKey = false; // the key EMPTY_KEY is in the set
+    bool hasTombstoneKey = false;
+    Hash hasher;
+
+    static bool isSentinel(T key) { return key == EMPTY_KEY || key == TOMBSTONE; }
+
+    void allocate(size_t cap) {
+        capacity = cap;
+        table = new T[capacity];
+        fill(table, table + capacity, EMPTY_KEY);
+        size_ = 0;
+        tombstones = 0;
+    }
+
+    // Slot index of key, or capacity if absent.
+    size_t locate(T key) const {
+        size_t idx = hasher(key) & (capacity - 1);
+        for (size_t i = 0; i < capacity; ++i) {
+            if (table[idx] == EMPTY_KEY) return capacity;
+            if (table[idx] == key) return idx;
+            idx = (idx + 1) & (capacity - 1);
+        }
+        return capacity;
+    }
+
+    void rehash(size_t new_cap) {
+        T* old_table = table;
+        size_t old_cap = capacity;
+        allocate(new_cap);
+        for (size_t i = 0; i < old_cap; ++i) {
+            if (!isSentinel(old_table[i])) {
+                size_t idx = hasher(old_table[i]) & (capacity - 1);
+                while (table[idx] != EMPTY_KEY) idx = (idx + 1) & (capacity - 1);
+                table[idx] = old_table[i];
+                ++size_;
+            }
+        }
+        delete[] old_table;
+    }
+
+public:
+    // --- Rule of 5 ---
+    FlatHashSet(size_t cap = 8, Hash h = Hash()) : hasher(h) {
+        size_t c = 8;
+        while (c < cap) c *= 2;
+        allocate(c);
+    }
+
+    ~FlatHashSet() {
+        delete[] table;
+    }
+
+    FlatHashSet(const FlatHashSet& other)
+        : capacity(other.capacity), size_(other.size_), tombstones(other.tombstones),
+          hasEmptyKey(other.hasEmptyKey), hasTombstoneKey(other.hasTombstoneKey), hasher(other.hasher) {
+        table = new T[capacity];
+        copy(other.table, other.table + capacity, table);
+    }
+
+    FlatHashSet& operator=(const FlatHashSet& other) {
+        if (this != &other) {
+            FlatHashSet copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    FlatHashSet(FlatHashSet&& other) noexcept
+        : table(other.table), capacity(other.capacity), size_(other.size_), tombstones(other.tombstones),
+          hasEmptyKey(other.hasEmptyKey), hasTombstoneKey(other.hasTombstoneKey), hasher(other.hasher) {
+        other.table = nullptr;
+        other.capacity = 0;
+        other.size_ = 0;
+        other.tombstones = 0;
+        other.hasEmptyKey = other.hasTombstoneKey = false;
+    }
+
+    FlatHashSet& operator=(FlatHashSet&& other) noexcept {
+        if (this != &other) {
+            delete[] table;
+            table = other.table;
+            capacity = other.capacity;
+            size_ = other.size_;
+            tombstones = other.tombstones;
+            hasEmptyKey = other.hasEmptyKey;
+            hasTombstoneKey = other.hasTombstoneKey;
+            hasher = other.hasher;
+            other.table = nullptr;
+            other.capacity = 0;
+            other.size_ = 0;
+            other.tombstones = 0;
+            other.hasEmptyKey = other.hasTombstoneKey = false;
+        }
+        return *this;
+    }
+
+    // --- Required virtual methods ---
+    bool insert(T key) override { return insert_impl(key); }
+    bool find(T key) const override { return find_impl(key); }
+    void remove(T key) override { remove_impl(key); }
+
+    // --- StaticSet implementation (keys by reference) ---
+    template <typename K>
+    bool insert_impl(K&& k) {
+        T key = k;
+        if (key == EMPTY_KEY) return !hasEmptyKey && (hasEmptyKey = true);
+        if (key == TOMBSTONE) return !hasTombstoneKey && (hasTombstoneKey = true);
+        if (capacity == 0) allocate(8);
+        if (locate(key) != capacity)
+            return false; // duplicate
+
+        if ((double)(size_ + tombstones + 1) / capacity > load_factor_threshold) {
+            // Grow if live keys need it, otherwise just drop the tombstones.
+            rehash((double)(size_ + 1) / capacity > load_factor_threshold / 2 ? capacity * 2 : capacity);
+        }
+        size_t idx = hasher(key) & (capacity - 1);
+        while (!isSentinel(table[idx])) idx = (idx + 1) & (capacity - 1);
+        if (table[idx] == TOMBSTONE) --tombstones;
+        table[idx] = key;
+        ++size_;
+        return true;
+    }
+
+    bool find_impl(const T& key) const {
+        if (key == EMPTY_KEY) return hasEmptyKey;
+        if (key == TOMBSTONE) return hasTombstoneKey;
+        return capacity != 0 && locate(key) != capacity;
+    }
+
+    void remove_impl(const T& key) {
+        if (key == EMPTY_KEY) { hasEmptyKey = false; return; }
+        if (key == TOMBSTONE) { hasTombstoneKey = false; return; }
+        if (capacity == 0) return;
+        size_t idx = locate(key);
+        if (idx == capacity) return;
+        table[idx] = TOMBSTONE;
+        ++tombstones;
+        --size_;
+    }
+
+    size_t size() const { return size_ + hasEmptyKey + hasTombstoneKey; }
+
+    size_t memory_bytes() const { return capacity * sizeof(T); }
+
+    void print() const {
+        cout << "{ ";
+        for (size_t i = 0; i < capacity; ++i) {
+            if (!isSentinel(table[i]))
+                cout << table[i] << " ";
+        }
+        if (hasTombstoneKey) cout << TOMBSTONE << " ";
+        if (hasEmptyKey) cout << EMPTY_KEY << " ";
+        cout << "}" << endl;
+    }
+};
+
+// Bucketized cuckoo hashing: 2 hash functions, 4-way buckets, small stash.
+// Every key lives in one of its two candidate buckets (or the stash), so
+// find() reads at most two buckets. A bucket is aligned and sized to fit
+// a cache line for small T. An insert into two full buckets runs a
+// breadth-first search for the shortest chain of displacements that ends
+// in a bucket with a free slot, then shifts the keys along that chain.
+// Short BFS paths keep inserts cheap, and load factors up to ~95% work.
+// Keys that cannot be placed go into the stash. The table doubles when
+// the stash overflows or the load factor passes max_load.
+template <typename T, typename Hash = SetHash<T>>
+class CuckooHashSet : public Set<T>, public StaticSet<CuckooHashSet<T, Hash>, T> {
+private:
+    static constexpr int WAYS = 4;
+    static constexpr size_t BUCKET_ALIGN = sizeof(T) * WAYS + 1 <= 32 ? 32 : 64;
+    static constexpr size_t MAX_BFS_NODES = 512;
+    static constexpr size_t STASH_LIMIT = 8;
+    static constexpr double max_load = 0.95;
+
+    struct alignas(BUCKET_ALIGN) Bucket {
+        T keys[WAYS];
+        uint8_t used = 0;    // bit w set = keys[w] holds a key
+    };
+
+    Bucket* buckets;
+    size_t numBuckets;       // power of two
+    size_t size_;
+    vector<T> stash;
+    Hash hasher;
+
+    size_t bucket1(uint64_t h) const { return h & (numBuckets - 1); }
+
+    size_t bucket2(uint64_t h) const {
+        // Independent bits for the second choice; never the same bucket.
+        size_t b = ((h >> 32) * 0x9E3779B97F4A7C15ULL >> 17) & (numBuckets - 1);
+        return b == bucket1(h) ? b ^ 1 : b;
+    }
+
+    size_t altBucket(const T& key, size_t b) const {
+        uint64_t h = hasher(key);
+        return b == bucket1(h) ? bucket2(h) : bucket1(h);
+    }
+
+    static int freeWay(const Bucket& b) {
+        for (int w = 0; w < WAYS; ++w)
+            if (!(b.used >> w & 1)) return w;
+        return -1;
+    }
+
+    int wayOf(const Bucket& b, const T& key) const {
+        for (int w = 0; w < WAYS; ++w)
+            if ((b.used >> w & 1) && b.keys[w] == key) return w;
+        return -1;
+    }
+
+    void put(size_t b, int w, T key) {
+        buckets[b].keys[w] = std::move(key);
+        buckets[b].used |= 1 << w;
+    }
+
+    // Place a key that is not in the set; returns false if it had to go to
+    // a full stash.
+    bool place(T key) {
+        uint64_t h = hasher(key);
+        size_t b1 = bucket1(h), b2 = bucket2(h);
+        for (size_t b : {b1, b2}) {
+            int w = freeWay(buckets[b]);
+            if (w >= 0) {
+                put(b, w, std::move(key));
+                return true;
+            }
+        }
+
+        // BFS over displacement chains. Node i: bucket reached by moving the
+        // key at nodes[parent].bucket[way] to its alternate bucket.
+        struct Node { size_t bucket; int parent; int way; };
+        Node nodes[MAX_BFS_NODES];
+        size_t count = 0;
+        nodes[count++] = {b1, -1, -1};
+        nodes[count++] = {b2, -1, -1};
+        for (size_t head = 0; head < count; ++head) {
+            const Bucket& from = buckets[nodes[head].bucket];
+            for (int w = 0; w < WAYS && count < MAX_BFS_NODES; ++w) {
+                size_t next = altBucket(from.keys[w], nodes[head].bucket);
+                // A bucket may appear only once on a chain.
+                bool onPath = false;
+                for (int p = (int)head; p >= 0; p = nodes[p].parent)
+                    if (nodes[p].bucket == next) { onPath = true; break; }
+                if (onPath) continue;
+
+                nodes[count] = {next, (int)head, w};
+                int free = freeWay(buckets[next]);
+                if (free >= 0) {
+                    // Shift keys along the chain, from the free end backwards.
+                    for (int i = (int)count; nodes[i].parent >= 0; i = nodes[i].parent) {
+                        const Node& n = nodes[i];
+                        Bucket& src = buckets[nodes[n.parent].bucket];
+                        put(n.bucket, free, std::move(src.keys[n.way]));
+                        src.used &= ~(1 << n.way);
+                        free = n.way;
+                    }
+                    int root = (int)count;
+                    while (nodes[root].parent >= 0) root = nodes[root].parent;
+                    put(nodes[root].bucket, free, std::move(key));
+                    return true;
+                }
+                ++count;
+            }
+        }
+
+        stash.push_back(std::move(key));
+        return stash.size() <= STASH_LIMIT;
+    }
+
+    void rehash(size_t new_buckets) {
+        Bucket* old = buckets;
+        size_t old_n = numBuckets;
+        vector<T> old_stash;
+        old_stash.swap(stash);
+
+        while (true) {
+            buckets = new Bucket[new_buckets];
+            numBuckets = new_buckets;
+            bool ok = true;
+            for (size_t b = 0; b < old_n && ok; ++b)
+                for (int w = 0; w < WAYS && ok; ++w)
+                    if (old[b].used >> w & 1) ok = place(old[b].keys[w]);
+            for (size_t i = 0; i < old_stash.size() && ok; ++i)
+                ok = place(old_stash[i]);
+            if (ok) break;
+            // Extremely unlucky: start over with an even larger table.
+            delete[] buckets;
+            stash.clear();
+            new_buckets *= 2;
+        }
+        delete[] old;
+    }
+
+public:
+    // --- Rule of 5 ---
+    CuckooHashSet(size_t cap = 16, Hash h = Hash()) : size_(0), hasher(h) {
+        numBuckets = 2;
+        while (numBuckets * WAYS * max_load < cap) numBuckets *= 2;
+        buckets = new Bucket[numBuckets];
+    }
+
+    ~CuckooHashSet() {
+        delete[] buckets;
+    }
+
+    CuckooHashSet(const CuckooHashSet& other)
+        : numBuckets(other.numBuckets), size_(other.size_), stash(other.stash), hasher(other.hasher) {
+        buckets = new Bucket[numBuckets];
+        for (size_t b = 0; b < numBuckets; ++b)
+            buckets[b] = other.buckets[b];
+    }
+
+    CuckooHashSet& operator=(const CuckooHashSet& other) {
+        if (this != &other) {
+            CuckooHashSet copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    CuckooHashSet(CuckooHashSet&& other) noexcept
+        : buckets(other.buckets), numBuckets(other.numBuckets), size_(other.size_),
+          stash(std::move(other.stash)), hasher(other.hasher) {
+        other.buckets = nullptr;
+        other.numBuckets = 0;
+        other.size_ = 0;
+    }
+
+    CuckooHashSet& operator=(CuckooHashSet&& other) noexcept {
+        if (this != &other) {
+            delete[] buckets;
+            buckets = other.buckets;
+            numBuckets = other.numBuckets;
+            size_ = other.size_;
+            stash = std::move(other.stash);
+            hasher = other.hasher;
+            other.buckets = nullptr;
+            other.numBuckets = 0;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    // --- Required virtual methods ---
+    bool insert(T key) override { return insert_impl(std::move(key)); }
+    bool find(T key) const override { return find_impl(key); }
+    void remove(T key) override { remove_impl(key); }
+
+    // --- StaticSet implementation (keys by reference) ---
+    template <typename K>
+    bool insert_impl(K&& key) {
+        if (numBuckets == 0) {
+            numBuckets = 2;
+            buckets = new Bucket[numBuckets];
+        }
+        if (find_impl(key))
+            return false; // duplicate
+        if ((double)(size_ + 1) / (numBuckets * WAYS) > max_load)
+            rehash(numBuckets * 2);
+        if (!place(std::forward<K>(key)))
+            rehash(numBuckets * 2);   // stash overflowed: grow, which empties it
+        ++size_;
+        return true;
+    }
+
+    bool find_impl(const T& key) const {
+        if (numBuckets == 0) return false;
+        uint64_t h = hasher(key);
+        if (wayOf(buckets[bucket1(h)], key) >= 0 || wayOf(buckets[bucket2(h)], key) >= 0)
+            return true;
+        for (const T& s : stash)
+            if (s == key) return true;
+        return false;
+    }
+
+    void remove_impl(const T& key) {
+        if (numBuckets == 0) return;
+        uint64_t h = hasher(key);
+        for (size_t b : {bucket1(h), bucket2(h)}) {
+            int w = wayOf(buckets[b], key);
+            if (w >= 0) {
+                buckets[b].used &= ~(1 << w);
+                --size_;
+                // A slot opened up: try to move a stashed key back in.
+                if (!stash.empty()) {
+                    T back = std::move(stash.back());
+                    stash.pop_back();
+                    place(std::move(back));
+                }
+                return;
+            }
+        }
+        for (size_t i = 0; i < stash.size(); ++i) {
+            if (stash[i] == key) {
+                stash.erase(stash.begin() + i);
+                --size_;
+                return;
+            }
+        }
+    }
+
+    size_t size() const { return size_; }
+
+    double load_factor() const { return numBuckets ? (double)size_ / (numBuckets * WAYS) : 0.0; }
+
+    size_t memory_bytes() const { return numBuckets * sizeof(Bucket) + stash.capacity() * sizeof(T); }
+
+    void print() const {
+        cout << "{ ";
+        for (size_t b = 0; b < numBuckets; ++b)
+            for (int w = 0; w < WAYS; ++w)
+                if (buckets[b].used >> w & 1)
+                    cout << buckets[b].keys[w] << " ";
+        for (const T& s : stash)
+            cout << s << " ";
+        cout << "}" << endl;
+    }
+};
+
+// Lock-free concurrent Set for integer keys (up to 32 bits).
+// Each slot is one 64-bit atomic word packing the key with its state:
+//   bits 0-31 key | bits 32-33 EMPTY/LIVE/DEAD | bit 34 FROZEN
+// A key claims a slot with a single CAS from EMPTY and owns it for the
+// lifetime of that table: remove() flips LIVE -> DEAD, and re-inserting
+// flips it back. Two threads inserting the same key therefore race for
+// the same slot, and exactly one wins.
+//
+// Growth is cooperative. The thread that crosses the load limit installs
+// a larger table in `next`. From then on every operation on the old table
+// helps out. It freezes the old slots on its own key's probe chain and
+// copies their live keys forward before working in the new table. It also
+// migrates one chunk of CHUNK slots. Frozen slots can no longer change,
+// so no update can be lost between the two tables. The root pointer moves
+// forward once all chunks are done.
+// Superseded tables are freed by a two-epoch quiescent-state scheme (see
+// Reader below), so repeated resizes of a set of constant size do not
+// accumulate memory. Single-threaded, the extra atomics make this set
+// slower than a HashSet behind a mutex; it pays off under contention.
+template <typename T, typename Hash = SetHash<T>>
+class ConcurrentHashSet : public Set<T>, public StaticSet<ConcurrentHashSet<T, Hash>, T> {
+    static_assert(is_integral_v<T> && sizeof(T) <= 4,
+                  "ConcurrentHashSet packs the key into 32 bits");
+
+private:
+    static constexpr uint64_t KEY_MASK = 0xFFFFFFFFULL;
+    static constexpr uint64_t STATE_MASK = 3ULL << 32;
+    static constexpr uint64_t EMPTY = 0;
+    static constexpr uint64_t LIVE = 1ULL << 32;
+    static constexpr uint64_t DEAD = 2ULL << 32;
+    static constexpr uint64_t FROZEN = 1ULL << 34;
+    static constexpr size_t CHUNK = 256;           // slots migrated per helping step
+    static constexpr double load_factor_threshold = 0.5;
+
+    struct Table {
+        size_t capacity;                           // power of two
+        unique_ptr<atomic<uint64_t>[]> slots;
+        atomic<size_t> used{0};                    // slots ever claimed (LIVE or DEAD)
+        atomic<Table*> next{nullptr};              // resize target, once started
+        atomic<size_t> chunksClaimed{0};
+        atomic<size_t> chunksDone{0};
+
+        explicit Table(size_t cap) : capacity(cap), slots(new atomic<uint64_t>[cap]) {
+            for (size_t i = 0; i < cap; ++i) slots[i].store(EMPTY, memory_order_relaxed);
+        }
+        size_t chunks() const { return (capacity + CHUNK - 1) / CHUNK; }
+    };
+
+    Table* first;                                  // oldest unretired table; tables chain via next
+    atomic<Table*> root;                           // newest fully migrated table
+    atomic<size_t> size_{0};
+    Hash hasher;
+
+    // Every operation counts itself in readers[epoch & 1] while it holds
+    // Table pointers. Tables that root has moved past are retired with the
+    // epoch of that moment. The epoch advances only once no reader of the
+    // previous epoch is left, so two advances after retirement no thread can
+    // still be probing the table and it is freed. Counters are striped by
+    // thread so readers do not all contend on one cache line.
+    static constexpr size_t READER_STRIPES = 16;
+    struct alignas(64) ReaderCount { atomic<size_t> n{0}; };
+    ReaderCount readers[2][READER_STRIPES];
+    atomic<uint64_t> epoch{0};
+    atomic<bool> retirePending{false};
+    atomic_flag reclaiming = ATOMIC_FLAG_INIT;
+    vector<pair<Table*, uint64_t>> retired;        // {table, epoch}; only touched while `reclaiming`
+
+    static size_t stripe() {
+        static thread_local size_t mine = hash<thread::id>()(this_thread::get_id()) % READER_STRIPES;
+        return mine;
+    }
+
+    // Registers the calling thread as a reader for the guard's lifetime and
+    // lets it reclaim retired tables on the way out.
+    class Reader {
+        ConcurrentHashSet* set;
+        atomic<size_t>* count;
+
+    public:
+        explicit Reader(const ConcurrentHashSet* s) : set(const_cast<ConcurrentHashSet*>(s)) {
+            while (true) {
+                uint64_t e = set->epoch.load();
+                count = &set->readers[e & 1][stripe()].n;
+                count->fetch_add(1);
+                if (set->epoch.load() == e) return;
+                count->fetch_sub(1);                // epoch moved on: register in the new one
+            }
+        }
+        ~Reader() {
+            count->fetch_sub(1);
+            if (set->retirePending.load(memory_order_relaxed)) set->reclaim();
+        }
+    };
+
+    // Retire the tables root has moved past, advance the epoch if the
+    // previous one has drained, and free what no reader can still see.
+    // Only one thread reclaims at a time; the others skip it.
+    void reclaim() {
+        if (reclaiming.test_and_set(memory_order_acquire)) return;
+        uint64_t e = epoch.load();
+        Table* r = root.load();
+        for (; first != r; first = first->next.load(memory_order_acquire))
+            retired.emplace_back(first, e);
+
+        bool drained = true;
+        for (auto& c : readers[(e + 1) & 1]) drained = drained && c.n.load() == 0;
+        if (drained) epoch.store(++e);             // only the reclaiming thread moves the epoch
+
+        size_t kept = 0;
+        for (auto& [t, tag] : retired) {
+            if (tag + 2 <= e) delete t;
+            else retired[kept++] = {t, tag};
+        }
+        retired.resize(kept);
+        // A root move racing with this store is picked up by the next one.
+        retirePending.store(!retired.empty() || root.load() != first, memory_order_relaxed);
+        reclaiming.clear(memory_order_release);
+    }
+
+    static uint64_t bitsOf(T key) { return static_cast<uint32_t>(key); }
+    static T keyOf(uint64_t w) { return static_cast<T>(static_cast<uint32_t>(w & KEY_MASK)); }
+
+    size_t home(const Table* t, uint64_t k) const {
+        return hasher(keyOf(k)) & (t->capacity - 1);
+    }
+
+    void startResize(Table* t) {
+        if (t->next.load(memory_order_acquire)) return;
+        size_t live = size_.load(memory_order_relaxed);
+        // Mostly dead slots: same size is enough to purge them.
+        size_t cap = live * 4 > t->capacity ? t->capacity * 2 : t->capacity;
+        Table* fresh = new Table(cap);
+        Table* expected = nullptr;
+        if (!t->next.compare_exchange_strong(expected, fresh, memory_order_acq_rel))
+            delete fresh;                          // another thread won
+    }
+
+    // Set FROZEN on slot idx of t and return the frozen word.
+    static uint64_t freeze(Table* t, size_t idx) {
+        uint64_t w = t->slots[idx].load(memory_order_acquire);
+        while (!(w & FROZEN)) {
+            if (t->slots[idx].compare_exchange_weak(w, w | FROZEN, memory_order_acq_rel))
+                return w | FROZEN;
+        }
+        return w;
+    }
+
+    // Freeze k's probe chain in t (up to its first EMPTY) and copy every live
+    // key on it into t->next. Afterwards k can only change in t->next.
+    void promoteChain(Table* t, uint64_t k) {
+        Table* n = t->next.load(memory_order_acquire);
+        size_t idx = home(t, k);
+        for (size_t i = 0; i < t->capacity; ++i) {
+            uint64_t w = freeze(t, idx);
+            if ((w & STATE_MASK) == EMPTY) return;
+            if ((w & STATE_MASK) == LIVE) insertKey(n, w & KEY_MASK, false);
+            idx = (idx + 1) & (t->capacity - 1);
+        }
+    }
+
+    // Migrate one chunk of t, then try to move the root forward.
+    void helpMigrate(Table* t) {
+        Table* n = t->next.load(memory_order_acquire);
+        size_t c = t->chunksClaimed.fetch_add(1, memory_order_relaxed);
+        if (c < t->chunks()) {
+            size_t end = min(t->capacity, (c + 1) * CHUNK);
+            for (size_t idx = c * CHUNK; idx < end; ++idx) {
+                uint64_t w = freeze(t, idx);
+                if ((w & STATE_MASK) == LIVE) insertKey(n, w & KEY_MASK, false);
+            }
+            t->chunksDone.fetch_add(1, memory_order_acq_rel);
+        }
+
+        Table* r = root.load(memory_order_acquire);
+        while (r->next.load(memory_order_acquire) &&
+               r->chunksDone.load(memory_order_acquire) == r->chunks()) {
+            Table* n2 = r->next.load(memory_order_acquire);
+            if (root.compare_exchange_strong(r, n2, memory_order_acq_rel))
+                retirePending.store(true, memory_order_relaxed);
+            r = root.load(memory_order_acquire);
+        }
+    }
+
+    // Insert k starting at table t. `revive` = normal insert (DEAD -> LIVE);
+    // migration copies pass false so they never resurrect a removed key.
+    // Returns true if this call made k live.
+    bool insertKey(Table* t, uint64_t k, bool revive) {
+        while (true) {
+            if (t->next.load(memory_order_acquire)) {
+                promoteChain(t, k);
+                helpMigrate(t);
+                t = t->next.load(memory_order_acquire);
+                continue;
+            }
+
+            size_t idx = home(t, k);
+            bool moved = false;
+            for (size_t i = 0; i < t->capacity && !moved; ) {
+                uint64_t w = t->slots[idx].load(memory_order_acquire);
+                if (w & FROZEN) { moved = true; break; }
+
+                if ((w & STATE_MASK) == EMPTY) {
+                    if (t->used.load(memory_order_relaxed) >= t->capacity * load_factor_threshold) {
+                        startResize(t);
+                        moved = true;
+                        break;
+                    }
+                    if (t->slots[idx].compare_exchange_strong(w, LIVE | k, memory_order_acq_rel)) {
+                        t->used.fetch_add(1, memory_order_relaxed);
+                        return true;
+                    }
+                    continue;                      // slot changed under us: look again
+                }
+                if ((w & KEY_MASK) == k) {
+                    if ((w & STATE_MASK) == LIVE || !revive) return false;
+                    if (t->slots[idx].compare_exchange_strong(w, LIVE | k, memory_order_acq_rel))
+                        return true;
+                    continue;
+                }
+                idx = (idx + 1) & (t->capacity - 1);
+                ++i;
+            }
+            if (!moved) startResize(t);            // wrapped around a full table
+        }
+    }
+
+public:
+    ConcurrentHashSet(size_t cap = 64) {
+        size_t c = 16;
+        while (c < cap) c *= 2;
+        first = new Table(c);
+        root.store(first);
+    }
+
+    ~ConcurrentHashSet() {
+        for (auto& [t, tag] : retired) delete t;
+        for (Table* t = first; t; ) {
+            Table* n = t->next.load();
+            delete t;
+            t = n;
+        }
+    }
+
+    ConcurrentHashSet(const ConcurrentHashSet&) = delete;
+    ConcurrentHashSet& operator=(const ConcurrentHashSet&) = delete;
+
+    // --- Required virtual methods ---
+    bool insert(T key) override { return insert_impl(std::move(key)); }
+    bool find(T key) const override { return find_impl(key); }
+    void remove(T key) override { remove_impl(key); }
+
+    // --- StaticSet implementation (keys by reference) ---
+    template <typename K>
+    bool insert_impl(K&& key) {
+        Reader guard(this);
+        bool added = insertKey(root.load(memory_order_acquire), bitsOf(key), true);
+        if (added) size_.fetch_add(1, memory_order_relaxed);
+        return added;
+    }
+
+    bool find_impl(const T& key) const {
+        auto* self = const_cast<ConcurrentHashSet*>(this);  // find may help a resize
+        Reader guard(this);
+        uint64_t k = bitsOf(key);
+        Table* t = root.load(memory_order_acquire);
+        while (true) {
+            size_t idx = home(t, k);
+            bool moved = false;
+            for (size_t i = 0; i < t->capacity; ++i) {
+                uint64_t w = t->slots[idx].load(memory_order_acquire);
+                if (w & FROZEN) { moved = true; break; }
+                if ((w & STATE_MASK) == EMPTY) return false;
+                if ((w & KEY_MASK) == k) return (w & STATE_MASK) == LIVE;
+                idx = (idx + 1) & (t->capacity - 1);
+            }
+            Table* n = t->next.load(memory_order_acquire);
+            if (!moved && !n) return false;
+            // Part of the chain already moved: bring the rest along, then
+            // the answer is in the next table.
+            self->promoteChain(t, k);
+            t = n;
+        }
+    }
+
+    void remove_impl(const T& key) {
+        remove_key(key);
+    }
+
+    // remove() that reports whether this call removed the key.
+    bool remove_key(T key) {
+        Reader guard(this);
+        uint64_t k = bitsOf(key);
+        Table* t = root.load(memory_order_acquire);
+        while (true) {
+            if (t->next.load(memory_order_acquire)) {
+                promoteChain(t, k);
+                helpMigrate(t);
+                t = t->next.load(memory_order_acquire);
+                continue;
+            }
+
+            size_t idx = home(t, k);
+            bool moved = false;
+            for (size_t i = 0; i < t->capacity; ) {
+                uint64_t w = t->slots[idx].load(memory_order_acquire);
+                if (w & FROZEN) { moved = true; break; }
+                if ((w & STATE_MASK) == EMPTY) return false;
+                if ((w & KEY_MASK) == k) {
+                    if ((w & STATE_MASK) == DEAD) return false;
+                    if (t->slots[idx].compare_exchange_strong(w, DEAD | k, memory_order_acq_rel)) {
+                        size_.fetch_sub(1, memory_order_relaxed);
+                        return true;
+                    }
+                    continue;
+                }
+                idx = (idx + 1) & (t->capacity - 1);
+                ++i;
+            }
+            if (!moved) return false;
+        }
+    }
+
+    size_t size() const { return size_.load(memory_order_relaxed); }
+
+    // Tables still allocated: the live chain plus retired ones not yet freed.
+    // Call while no other thread is using the set.
+    size_t table_count() const {
+        size_t n = retired.size();
+        for (Table* t = first; t; t = t->next.load()) ++n;
+        return n;
+    }
+};
+
+// ------------------ Churn benchmark ------------------
+// Usage: ./unordered_set_buggy churn [live_keys=100000] [rounds=20]
+// Keeps `live_keys` keys in the set and, each round, removes and re-inserts
+// live_keys random keys, then times live_keys lookups of absent keys.
+// Tombstones lengthen HashSet misses until they push it over its load
+// threshold and a same-size rebuild sweeps them. Robin Hood probe lengths
+// should stay flat.
+template <typename Func>
+double secondsOf(Func func) {
+    auto start = chrono::steady_clock::now();
+    func();
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double>(end - start).count();
+}
+
+template <typename S>
+void churnRound(S& s, vector<int>& live, mt19937_64& rng, int& nextKey) {
+    for (size_t i = 0; i < live.size(); ++i) {
+        size_t victim = rng() % live.size();
+        s.remove(live[victim]);
+        live[victim] = nextKey++;
+        s.insert(live[victim]);
+    }
+}
+
+int runChurnBenchmark(int argc, char** argv) {
+    int liveKeys = argc > 2 ? stoi(argv[2]) : 100000;
+    int rounds = argc > 3 ? stoi(argv[3]) : 20;
+
+    HashSet<int> linear;
+    RobinHoodHashSet<int> robin;
+    vector<int> liveLinear, liveRobin;
+    for (int k = 0; k < liveKeys; ++k) {
+        linear.insert(k);
+        robin.insert(k);
+        liveLinear.push_back(k);
+        liveRobin.push_back(k);
+    }
+    int nextLinear = liveKeys, nextRobin = liveKeys;
+    mt19937_64 rngLinear(42), rngRobin(42);
+
+    cout << "round  linear_churn_s  linear_miss_ns  robin_churn_s  robin_miss_ns  robin_max_probe  robin_avg_probe\n";
+    for (int r = 1; r <= rounds; ++r) {
+        double linearChurn = secondsOf([&] { churnRound(linear, liveLinear, rngLinear, nextLinear); });
+        double robinChurn = secondsOf([&] { churnRound(robin, liveRobin, rngRobin, nextRobin); });
+
+        size_t hits = 0;
+        double linearMiss = secondsOf([&] {
+            for (int k = 0; k < liveKeys; ++k) hits += linear.find(-1 - k);
+        });
+        double robinMiss = secondsOf([&] {
+            for (int k = 0; k < liveKeys; ++k) hits += robin.find(-1 - k);
+        });
+
+        cout << r << "  " << linearChurn << "  " << linearMiss * 1e9 / liveKeys
+             << "  " << robinChurn << "  " << robinMiss * 1e9 / liveKeys
+             << "  " << robin.max_probe() << "  " << robin.avg_probe()
+             << (hits ? "  (unexpected hit)" : "") << "\n";
+    }
+    return 0;
+}
+
+// ------------------ Hash benchmark ------------------
+// Usage: ./unordered_set_buggy hashbench [keys=262144]
+// Inserts and looks up strided (multiples of 64) and random 64-bit keys with
+// IdentityHash (the old `key % capacity` placement) and SetHash, reporting
+// ns per operation and the average/maximum probe distance.
+template <typename Hash>
+void hashBenchRow(const string& keysName, const string& hashName, const vector<long long>& keys) {
+    HashSet<long long, Hash> s;
+    double insertSec = secondsOf([&] {
+        for (long long k : keys) s.insert(k);
+    });
+    size_t hits = 0;
+    double findSec = secondsOf([&] {
+        for (long long k : keys) hits += s.find(k);
+    });
+    cout << keysName << "  " << hashName << "  "
+         << insertSec * 1e9 / keys.size() << "  " << findSec * 1e9 / keys.size() << "  "
+         << s.avg_probe() << "  " << s.max_probe()
+         << (hits != keys.size() ? "  (missing keys!)" : "") << "\n";
+}
+
+int runHashBenchmark(int argc, char** argv) {
+    size_t n = argc > 2 ? stoul(argv[2]) : 262144;
+    vector<long long> strided(n), random(n);
+    mt19937_64 rng(42);
+    for (size_t i = 0; i < n; ++i) {
+        strided[i] = (long long)i * 64;
+        random[i] = (long long)(rng() >> 1);
+    }
+
+    cout << "keys  hash  insert_ns  find_ns  avg_probe  max_probe\n";
+    hashBenchRow<IdentityHash<long long>>("strided64", "identity", strided);
+    hashBenchRow<SetHash<long long>>("strided64", "SetHash", strided);
+    hashBenchRow<IdentityHash<long long>>("random", "identity", random);
+    hashBenchRow<SetHash<long long>>("random", "SetHash", random);
+    return 0;
+}
+
+// ------------------ Insert latency benchmark ------------------
+// Usage: ./unordered_set_buggy latency [keys=4000000]
+// Times every single insert and prints latency percentiles. HashSet's
+// rehash-in-one-call shows up at p99.9/max; IncrementalHashSet spreads it.
+// Then churn at constant size: each step removes a random live key, inserts
+// a fresh one and looks up an absent one. Without tombstone purging, the
+// absent lookups degrade until they scan the whole table.
+template <typename S>
+void latencyRow(const string& name, size_t n) {
+    S s;
+    vector<double> ns(n);
+    mt19937_64 rng(42);
+    for (size_t i = 0; i < n; ++i) {
+        int key = (int)(rng() >> 33);
+        auto start = chrono::steady_clock::now();
+        s.insert(key);
+        auto end = chrono::steady_clock::now();
+        ns[i] = chrono::duration<double, nano>(end - start).count();
+    }
+    sort(ns.begin(), ns.end());
+    auto pct = [&](double p) { return ns[min(n - 1, (size_t)(p * n))]; };
+    cout << name << "  " << pct(0.5) << "  " << pct(0.99) << "  " << pct(0.999)
+         << "  " << ns.back() << "\n";
+}
+
+template <typename S>
+void churnLatencyRow(const string& name, size_t live, size_t steps) {
+    S s;
+    vector<int> keys(live);
+    for (size_t i = 0; i < live; ++i) s.insert(keys[i] = (int)i);
+    vector<double> ns(steps);
+    mt19937_64 rng(42);
+    int next = (int)live;
+    size_t hits = 0;
+    for (size_t i = 0; i < steps; ++i) {
+        size_t victim = rng() % live;
+        auto start = chrono::steady_clock::now();
+        s.remove(keys[victim]);
+        s.insert(keys[victim] = next++);
+        hits += s.find(-1 - (int)i);
+        auto end = chrono::steady_clock::now();
+        ns[i] = chrono::duration<double, nano>(end - start).count();
+    }
+    sort(ns.begin(), ns.end());
+    auto pct = [&](double p) { return ns[min(steps - 1, (size_t)(p * steps))]; };
+    cout << name << "  " << pct(0.5) << "  " << pct(0.99) << "  " << pct(0.999) << "  " << ns.back()
+         << (hits || s.size() != live ? "  (wrong contents!)" : "") << "\n";
+}
+
+int runLatencyBenchmark(int argc, char** argv) {
+    size_t n = argc > 2 ? stoul(argv[2]) : 4000000;
+    cout << "set  p50_ns  p99_ns  p99.9_ns  max_ns\n";
+    latencyRow<HashSet<int>>("HashSet", n);
+    latencyRow<IncrementalHashSet<int>>("IncrementalHashSet", n);
+    cout << "churn (" << n / 8 << " live keys, remove + insert + miss per step)\n";
+    churnLatencyRow<HashSet<int>>("HashSet", n / 8, n);
+    churnLatencyRow<IncrementalHashSet<int>>("IncrementalHashSet", n / 8, n);
+    return 0;
+}
+
+// ------------------ Batched lookup benchmark ------------------
+// Usage: ./unordered_set_buggy batch [keys=16000000]
+// Fills a HashSet<int> far larger than the last-level cache (16M keys =
+// 32M 8-byte slots = 256 MB), then looks up random keys (about half hits)
+// in batches of 64..1024, with a find() loop and with find_many().
+int runBatchBenchmark(int argc, char** argv) {
+    size_t n = argc > 2 ? stoul(argv[2]) : 16000000;
+    HashSet<int> s;
+    vector<int> keys(n);
+    mt19937_64 rng(42);
+    for (auto& k : keys) k = (int)(rng() >> 33) * 2;   // even keys only
+    double buildLoop = secondsOf([&] { for (int k : keys) s.insert(k); });
+
+    HashSet<int> batched;
+    double buildBatch = secondsOf([&] { batched.insert_many(keys); });
+    cout << "build " << n << " keys: insert loop " << buildLoop * 1e9 / n
+         << " ns/key, insert_many " << buildBatch * 1e9 / n << " ns/key\n";
+
+    const size_t lookups = 4000000;
+    cout << "batch  loop_ns_per_key  find_many_ns_per_key\n";
+    for (size_t batch : {64, 256, 1024}) {
+        vector<int> probe(batch);
+        vector<uint64_t> bits;
+        size_t hitsLoop = 0, hitsBatch = 0;
+        mt19937_64 qrng(7);
+        double loop = 0, many = 0;
+        for (size_t done = 0; done < lookups; done += batch) {
+            for (auto& k : probe) k = (int)(qrng() >> 33);  // odd keys miss
+            loop += secondsOf([&] { for (int k : probe) hitsLoop += s.find(k); });
+            many += secondsOf([&] { s.find_many(probe, bits); });
+            for (uint64_t w : bits) hitsBatch += __builtin_popcountll(w);
+        }
+        cout << batch << "  " << loop * 1e9 / lookups << "  " << many * 1e9 / lookups
+             << (hitsLoop != hitsBatch ? "  (results differ!)" : "") << "\n";
+    }
+    return 0;
+}
+
+// ------------------ Dispatch benchmark ------------------
+// Usage: ./unordered_set_buggy dispatch [lookups=20000000]
+// The same HashSet is queried through Set<T>* (virtual call, key copied
+// into a by-value parameter) and through StaticSet<HashSet<T>, T>& (direct,
+// inlinable call, key by const&). The set is small and cache-resident, so the
+// difference is call overhead plus, for long strings, the per-call copy.
+template <typename T>
+size_t lookupVirtual(const Set<T>& s, const vector<T>& keys, size_t lookups) {
+    size_t hits = 0;
+    for (size_t i = 0; i < lookups; ++i)
+        hits += s.find(keys[i & (keys.size() - 1)]);
+    return hits;
+}
+
+template <typename Impl, typename T>
+size_t lookupStatic(const StaticSet<Impl, T>& s, const vector<T>& keys, size_t lookups) {
+    size_t hits = 0;
+    for (size_t i = 0; i < lookups; ++i)
+        hits += s.contains(keys[i & (keys.size() - 1)]);
+    return hits;
+}
+
+template <typename T>
+void dispatchRow(const string& name, const vector<T>& keys, size_t lookups) {
+    HashSet<T> s;
+    for (size_t i = 0; i < keys.size(); i += 2) s.insert(keys[i]);   // half the keys hit
+
+    // Through a volatile pointer the compiler cannot see the dynamic type.
+    Set<T>* volatile base = &s;
+    size_t hitsV = 0, hitsS = 0;
+    double virt = secondsOf([&] { hitsV = lookupVirtual(*base, keys, lookups); });
+    double stat = secondsOf([&] { hitsS = lookupStatic(s, keys, lookups); });
+    cout << name << "  " << virt * 1e9 / lookups << "  " << stat * 1e9 / lookups
+         << (hitsV != hitsS ? "  (results differ!)" : "") << "\n";
+}
+
+int runDispatchBenchmark(int argc, char** argv) {
+    size_t lookups = argc > 2 ? stoul(argv[2]) : 20000000;
+    const size_t distinct = 1024;   // power of two, see the index mask above
+
+    vector<int> ints(distinct);
+    vector<string> strings(distinct);
+    mt19937_64 rng(42);
+    for (size_t i = 0; i < distinct; ++i) {
+        ints[i] = (int)(rng() >> 33);
+        strings[i] = "customer/" + to_string(rng()) + "/profile";   // longer than the SSO buffer
+    }
+
+    cout << "key  virtual_ns  static_ns\n";
+    dispatchRow("int", ints, lookups);
+    dispatchRow("string", strings, lookups);
+    return 0;
+}
+
+// ------------------ Cuckoo benchmark ------------------
+// Usage: ./unordered_set_buggy cuckoo [keys=3900000]
+// Fills a CuckooHashSet sized for ~94% load and a HashSet (max load 0.6)
+// with the same random ints, then compares memory and hit/miss lookup time.
+template <typename S>
+void cuckooRow(const string& name, S& s, const vector<int>& keys) {
+    double build = secondsOf([&] { for (int k : keys) s.insert(k); });
+    size_t hits = 0;
+    double hit = secondsOf([&] { for (int k : keys) hits += s.find(k); });
+    double miss = secondsOf([&] { for (int k : keys) hits += s.find(k + 1); });  // keys are even
+    size_t n = keys.size();
+    cout << name << "  " << s.load_factor() << "  " << s.memory_bytes() / 1048576.0 << "  "
+         << build * 1e9 / n << "  " << hit * 1e9 / n << "  " << miss * 1e9 / n
+         << (hits != n ? "  (wrong results!)" : "") << "\n";
+}
+
+int runCuckooBenchmark(int argc, char** argv) {
+    size_t n = argc > 2 ? stoul(argv[2]) : 3900000;   // 93% of 2^20 four-way buckets
+    vector<int> keys;
+    mt19937_64 rng(42);
+    FlatHashSet<int> seen;
+    while (keys.size() < n) {
+        int k = (int)(rng() >> 34) * 2;
+        if (seen.insert(k)) keys.push_back(k);
+    }
+
+    // Smallest power-of-two bucket count that holds n keys at <= 95% load.
+    size_t buckets = 2;
+    while (buckets * 4 * 0.95 < n) buckets *= 2;
+    CuckooHashSet<int> cuckoo(buckets * 4 * 0.95);
+    HashSet<int> linear;
+
+    cout << "set  load  MiB  insert_ns  hit_ns  miss_ns\n";
+    cuckooRow("CuckooHashSet", cuckoo, keys);
+    cuckooRow("HashSet", linear, keys);
+    return 0;
+}
+
+// ------------------ Snapshot benchmark ------------------
+// Usage: ./unordered_set_buggy snapshot [keys=20000000] [path=/tmp/hashset.snap]
+// Compares warm-starting a HashSet<int> by re-inserting every key against
+// load() of a saved snapshot. It times the lazy map, the map plus a full data
+// checksum, and the first lookups (which fault the pages in). The snapshot
+// must answer every lookup exactly as the original table does.
+int runSnapshotBenchmark(int argc, char** argv) {
+    size_t n = argc > 2 ? stoul(argv[2]) : 20000000;
+    string path = argc > 3 ? argv[3] : "/tmp/hashset.snap";
+    vector<int> keys(n);
+    mt19937_64 rng(42);
+    for (auto& k : keys) k = (int)(rng() >> 33) * 2;   // even keys only
+
+    SetHash<int> salted;
+    salted.seed = rng();
+    HashSet<int> original(8, salted);
+    double rebuild = secondsOf([&] { for (int k : keys) original.insert(k); });
+    double save = secondsOf([&] { original.save(path); });
+
+    double lazy = secondsOf([&] { HashSet<int>::load(path); });
+    double verified = secondsOf([&] { HashSet<int>::load(path, true); });
+    HashSet<int> loaded = HashSet<int>::load(path);
+
+    const size_t lookups = 4000000;
+    vector<int> probe(lookups);
+    for (auto& k : probe) k = (int)(rng() >> 33);   // odd keys miss
+    size_t mismatches = 0;
+    double firstTouch = secondsOf([&] {
+        for (int k : probe) mismatches += loaded.find(k) != original.find(k);
+    });
+    mismatches += loaded.size() != original.size();
+    loaded.insert(1);   // copy-on-write: the file is not modified
+
+    cout << "keys " << n << ", table " << original.memory_bytes() / 1048576.0 << " MiB\n";
+    cout << "rebuild_by_insert_ms " << rebuild * 1e3 << "\n";
+    cout << "save_ms " << save * 1e3 << "\n";
+    cout << "load_ms " << lazy * 1e3 << "\n";
+    cout << "load_verified_ms " << verified * 1e3 << "\n";
+    cout << "first_" << lookups << "_lookups_ms " << firstTouch * 1e3 << "\n";
+    cout << (mismatches ? "snapshot differs from original!" : "snapshot matches original") << "\n";
+    remove(path.c_str());
+    return mismatches ? 1 : 0;
+}
+
+// ------------------ Bloom filter benchmark ------------------
+// Usage: ./unordered_set_buggy bloom [keys=9800000]
+// Miss-heavy lookups (90% misses, as in production) on a HashSet<int> near
+// its 0.6 maximum load (9.8M keys in 2^24 slots, 128 MiB), without a filter and with filters of 8..16 bits
+// per key. Reports the measured false-positive rate (misses the filter let
+// through) and the filter's memory next to the table's.
+int runBloomBenchmark(int argc, char** argv) {
+    size_t n = argc > 2 ? stoul(argv[2]) : 9800000;
+    vector<int> keys(n);
+    mt19937_64 rng(42);
+    for (auto& k : keys) k = (int)(rng() >> 33) * 2;   // even keys only
+    HashSet<int> s;
+    for (int k : keys) s.insert(k);
+
+    const size_t lookups = 8000000;
+    vector<int> probe(lookups);
+    for (size_t i = 0; i < lookups; ++i)
+        probe[i] = i % 10 == 0 ? keys[rng() % n] : (int)(rng() >> 33) * 2 + 1;   // odd keys miss
+
+    cout << "table " << s.memory_bytes() / 1048576.0 << " MiB, load " << s.load_factor() << "\n";
+    cout << "bits_per_key  filter_MiB  overhead_pct  false_pos_pct  find_ns  find_many_ns\n";
+    size_t expected = 0;
+    for (double bits : {0.0, 8.0, 12.0, 16.0}) {
+        if (bits == 0) s.disable_filter();
+        else s.enable_filter(bits);
+        size_t hits = 0, passed = 0, misses = 0;
+        double single = secondsOf([&] { for (int k : probe) hits += s.find(k); });
+        vector<uint64_t> out;
+        double batched = secondsOf([&] { s.find_many(probe, out); });
+        for (int k : probe) {
+            if (k & 1) {
+                ++misses;
+                passed += s.filter_may_contain(k);
+            }
+        }
+        if (bits == 0) expected = hits;
+        cout << bits << "  " << s.filter_bytes() / 1048576.0 << "  "
+             << 100.0 * s.filter_bytes() / s.memory_bytes() << "  "
+             << (bits == 0 ? 100.0 : 100.0 * passed / misses) << "  "
+             << single * 1e9 / lookups << "  " << batched * 1e9 / lookups
+             << (hits != expected ? "  (wrong results!)" : "") << "\n";
+    }
+    return 0;
+}
+
+// ------------------ Bulk build benchmark ------------------
+// Usage: ./unordered_set_buggy bulk [keys=20000000] [max_threads=8]
+// Builds a HashSet<long long> from a vector: with an insert() loop, and with
+// the bulk constructor at 1, 2, 4, ... threads. It then times one parallel
+// doubling rehash (reserve(2 * size) on a copy) at each thread count. Every
+// parallel build must hold exactly the keys the serial one holds.
+int runBulkBenchmark(int argc, char** argv) {
+    size_t n = argc > 2 ? stoul(argv[2]) : 20000000;
+    unsigned maxThreads = argc > 3 ? stoul(argv[3]) : 8;
+    vector<long long> keys(n);
+    mt19937_64 rng(42);
+    for (auto& k : keys) k = (long long)(rng() >> 1);
+
+    HashSet<long long> serial;
+    double loop = secondsOf([&] { for (long long k : keys) serial.insert(k); });
+    cout << "keys " << n << ", insert loop " << loop * 1e3 << " ms (" << thread::hardware_concurrency()
+         << " hardware threads)\n";
+    cout << "threads  bulk_build_ms  rehash_ms\n";
+    for (unsigned t = 1; t <= maxThreads; t *= 2) {
+        HashSet<long long> bulk;
+        double build = secondsOf([&] { bulk = HashSet<long long>(keys.begin(), keys.end(), t); });
+        bool same = bulk.size() == serial.size();
+        for (size_t i = 0; same && i < n; i += 97) same = bulk.find(keys[i]) && !bulk.find(-keys[i] - 1);
+
+        HashSet<long long> grown = bulk;
+        double rehash = secondsOf([&] { grown.reserve(2 * grown.size()); });
+        for (size_t i = 0; same && i < n; i += 97) same = grown.find(keys[i]);
+        same = same && grown.size() == serial.size();
+        cout << t << "  " << build * 1e3 << "  " << rehash * 1e3 << (same ? "" : "  (contents differ!)") << "\n";
+    }
+    return 0;
+}
+
+// ------------------ Concurrent set stress test and scaling ------------------
+// Usage: ./unordered_set_buggy stress [threads=8] [keys_per_thread=20000]
+// Threads race on private and shared key ranges while the table keeps
+// resizing, and the results are checked against what a linearizable set
+// must produce:
+//   - each shared key is reported as newly inserted by exactly one thread,
+//     and later as removed by exactly one thread;
+//   - keys inserted before the race are never missed by concurrent finds;
+//     keys that are never inserted are never found;
+//   - the final contents and size() match the operations that succeeded.
+int runStressTest(int argc, char** argv) {
+    int threads = argc > 2 ? stoi(argv[2]) : 8;
+    int perThread = argc > 3 ? stoi(argv[3]) : 20000;
+    const int stable = 1000, privateBase = 1000000, sharedBase = 2000000;
+
+    ConcurrentHashSet<int> set(16);
+    for (int k = 0; k < stable; ++k) set.insert(k);
+
+    vector<atomic<int>> insertWins(perThread), removeWins(perThread);
+    for (int i = 0; i < perThread; ++i) {
+        insertWins[i].store(0);
+        removeWins[i].store(0);
+    }
+    atomic<int> failures{0};
+
+    auto checkStable = [&](mt19937_64& rng) {
+        int k = (int)(rng() % stable);
+        if (!set.find(k)) failures.fetch_add(1);   // inserted before the race
+        if (set.find(-1 - k)) failures.fetch_add(1);  // never inserted
+    };
+
+    auto phaseInsert = [&](int t) {
+        mt19937_64 rng(t);
+        for (int i = 0; i < perThread; ++i) {
+            if (!set.insert(privateBase + t * perThread + i)) failures.fetch_add(1);
+            int shared = (i + t * 7919) % perThread;  // threads hit the shared keys in different orders
+            if (set.insert(sharedBase + shared)) insertWins[shared].fetch_add(1);
+            checkStable(rng);
+        }
+    };
+    auto phaseRemove = [&](int t) {
+        mt19937_64 rng(t + 1000);
+        for (int i = 0; i < perThread; ++i) {
+            int shared = (i + t * 7919) % perThread;
+            if (set.remove_key(sharedBase + shared)) removeWins[shared].fetch_add(1);
+            if (i % 2 == 0 && !set.remove_key(privateBase + t * perThread + i)) failures.fetch_add(1);
+            checkStable(rng);
+        }
+    };
+
+    for (auto phase : {0, 1}) {
+        vector<thread> pool;
+        for (int t = 0; t < threads; ++t) {
+            if (phase == 0) pool.emplace_back(phaseInsert, t);
+            else pool.emplace_back(phaseRemove, t);
+        }
+        for (auto& th : pool) th.join();
+    }
+
+    for (int i = 0; i < perThread; ++i) {
+        if (insertWins[i].load() != 1 || removeWins[i].load() != 1) failures.fetch_add(1);
+        if (set.find(sharedBase + i)) failures.fetch_add(1);
+    }
+    for (int t = 0; t < threads; ++t)
+        for (int i = 0; i < perThread; ++i)
+            if (set.find(privateBase + t * perThread + i) != (i % 2 == 1)) failures.fetch_add(1);
+    size_t expected = stable + (size_t)threads * (perThread / 2);
+    if (set.size() != expected) failures.fetch_add(1);
+
+    // Insert/remove churn at a constant size keeps purging tombstones into
+    // same-size tables; the superseded ones must be freed along the way.
+    ConcurrentHashSet<int> churned(16);
+    for (int round = 0; round < 20; ++round) {
+        vector<thread> pool;
+        for (int t = 0; t < threads; ++t)
+            pool.emplace_back([&, t] {
+                int base = (round * threads + t) * perThread;
+                for (int i = 0; i < perThread; ++i) churned.insert(base + i);
+                for (int i = 0; i < perThread; ++i)
+                    if (!churned.remove_key(base + i)) failures.fetch_add(1);
+            });
+        for (auto& th : pool) th.join();
+    }
+    churned.find(0);   // one more quiescent pass to free what the last round retired
+    churned.find(0);
+    if (churned.size() != 0 || churned.table_count() > 2) failures.fetch_add(1);
+
+    cout << "stress: " << threads << " threads, " << perThread << " keys/thread, "
+         << (failures.load() ? "FAILED (" + to_string(failures.load()) + " violations)" : "OK") << endl;
+    return failures.load() ? 1 : 0;
+}
+
+// Usage: ./unordered_set_buggy scale [max_threads=16] [ops_per_thread=1000000]
+// 50% insert / 50% find on random keys, lock-free set vs. HashSet + one mutex.
+int runScalingBenchmark(int argc, char** argv) {
+    int maxThreads = argc > 2 ? stoi(argv[2]) : 16;
+    int ops = argc > 3 ? stoi(argv[3]) : 1000000;
+
+    auto run = [&](int threads, auto&& op) {
+        vector<thread> pool;
+        double sec = secondsOf([&] {
+            for (int t = 0; t < threads; ++t)
+                pool.emplace_back([&, t] {
+                    mt19937_64 rng(t);
+                    for (int i = 0; i < ops; ++i) op(rng());
+                });
+            for (auto& th : pool) th.join();
+        });
+        return (double)threads * ops / sec / 1e6;
+    };
+
+    cout << "threads  lockfree_Mops  mutex_Mops\n";
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        ConcurrentHashSet<int> lockFree;
+        double lf = run(threads, [&](uint64_t r) {
+            int key = (int)(r >> 40);
+            if (r & 1) lockFree.insert(key);
+            else lockFree.find(key);
+        });
+
+        HashSet<int> locked;
+        mutex m;
+        double mx = run(threads, [&](uint64_t r) {
+            int key = (int)(r >> 40);
+            lock_guard<mutex> lock(m);
+            if (r & 1) locked.insert(key);
+            else locked.find(key);
+        });
+        cout << threads << "  " << lf << "  " << mx << "\n";
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "churn")
+        return runChurnBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "hashbench")
+        return runHashBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "stress")
+        return runStressTest(argc, argv);
+    if (argc > 1 && string(argv[1]) == "scale")
+        return runScalingBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "latency")
+        return runLatencyBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "batch")
+        return runBatchBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "dispatch")
+        return runDispatchBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "cuckoo")
+        return runCuckooBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "snapshot")
+        return runSnapshotBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "bloom")
+        return runBloomBenchmark(argc, argv);
+    if (argc > 1 && string(argv[1]) == "bulk")
+        return runBulkBenchmark(argc, argv);
+
+    HashSet<int> s;
+    s.insert(10);
+    s.insert(20);
+    s.insert(30);
+    s.insert(20); // duplicate ignored
+
+    s.print();
+
+    cout << "Find 10: " << s.find(10) << endl;
+    cout << "Find 25: " << s.find(25) << endl;
+
+    s.remove(10);
+    s.print();
+
+    // Batched lookup: one bit per key
+    vector<uint64_t> bits;
+    s.find_many({10, 20, 30, 40}, bits);
+    cout << "find_many(10, 20, 30, 40) bits: " << bits[0] << endl;
+
+    // Test copy constructor
+    HashSet<int> copy = s;
+    copy.insert(40);
+    cout << "Copy: ";
+    copy.print();
+
+    // Test move constructor
+    HashSet<int> moved = std::move(copy);
+    cout << "Moved: ";
+    moved.print();
+
+    // The moved-from set is empty but still usable
+    copy.reserve(100);
+    copy.insert_many({1, 2, 3});
+    copy.insert(4);
+    copy.remove(1);
+    cout << "Moved-from after reserve/insert_many: size " << copy.size() << ", find 2: " << copy.find(2)
+         << endl;
+
+    // Insert after remove: 1, 9 and 17 share home slot 1, so removing 1 leaves
+    // a tombstone in front of 9. Re-inserting 9 must find it, not fill the hole.
+    HashSet<int, IdentityHash<int>> chain(8);
+    for (int k : {1, 9, 17}) chain.insert(k);
+    chain.remove(1);
+    bool again = chain.insert(9);
+    chain.remove(9);
+    cout << "Insert after remove: inserted again " << again << ", size " << chain.size()
+         << ", find 9 after remove: " << chain.find(9) << endl;
+
+    // Instrumented variant: probe histograms and table shape as JSON
+    HashSet<int, SetHash<int>, ProbeStats> probed;
+    for (int k = 0; k < 1000; ++k) probed.insert(k);
+    for (int k = 0; k < 1000; k += 3) probed.remove(k);
+    for (int k = 0; k < 2000; ++k) probed.find(k);
+    cout << "Stats: " << probed.stats_json() << endl;
+
+    // Swiss-table variant
+    SwissHashSet<string> words;
+    words.insert("apple");
+    words.insert("banana");
+    words.insert("apple"); // duplicate ignored
+    words.remove("banana");
+    cout << "Swiss: ";
+    words.print();
+    cout << "Find apple: " << words.find("apple") << endl;
+
+    // Static dispatch: same set, no virtual call, keys by reference
+    StaticSet<SwissHashSet<string>, string>& fast = words;
+    fast.add("cherry");
+    cout << "Contains cherry: " << fast.contains("cherry") << endl;
+
+    // Copying a moved-from set gives an empty set that still works
+    SwissHashSet<string> kept = std::move(words);
+    SwissHashSet<string> blank = words;
+    blank.insert("date");
+    cout << "Copy of moved-from Swiss: size " << blank.size() << ", find date: " << blank.find("date")
+         << ", kept " << kept.size() << endl;
+
+    // Robin Hood variant: remove() leaves no tombstones
+    RobinHoodHashSet<int> robin;
+    for (int k = 0; k < 100; ++k) robin.insert(k * 64);
+    for (int k = 0; k < 100; k += 2) robin.remove(k * 64);
+    cout << "Robin Hood: size " << robin.size() << ", max probe " << robin.max_probe()
+         << ", find 64: " << robin.find(64) << endl;
+
+    // Sentinel keys instead of per-slot state: half the memory for int keys
+    HashSet<int> slotted;
+    FlatHashSet<int> flat;
+    for (int k = 0; k < 100000; ++k) {
+        slotted.insert(k);
+        flat.insert(k);
+    }
+    flat.insert(numeric_limits<int>::max());   // sentinel value is still a valid key
+    cout << "Memory for 100000 ints: HashSet " << slotted.memory_bytes()
+         << " bytes, FlatHashSet " << flat.memory_bytes() << " bytes" << endl;
+
+    // Cuckoo hashing: any key is in one of two buckets
+    CuckooHashSet<int> cuckoo;
+    for (int k = 0; k < 1000; ++k) cuckoo.insert(k * 64);
+    cout << "Cuckoo: size " << cuckoo.size() << ", load " << cuckoo.load_factor()
+         << ", find 640: " << cuckoo.find(640) << endl;
+
+    // Incremental resizing: no single insert rehashes the whole table
+    IncrementalHashSet<int> gradual;
+    for (int k = 0; k < 1000; ++k) gradual.insert(k);
+    cout << "Incremental: size " << gradual.size() << ", find 999: " << gradual.find(999) << endl;
+    IncrementalHashSet<int> drained = std::move(gradual);
+    IncrementalHashSet<int> refilled = gradual;   // copy of a moved-from set
+    refilled.insert(7);
+    cout << "Copy of moved-from incremental: size " << refilled.size() << ", find 7: " << refilled.find(7)
+         << endl;
+
+    // Lock-free variant shared by several threads
+    ConcurrentHashSet<int> shared;
+    vector<thread> workers;
+    for (int t = 0; t < 4; ++t)
+        workers.emplace_back([&shared, t] {
+            for (int k = 0; k < 1000; ++k) shared.insert(t * 1000 + k);
+        });
+    for (auto& th : workers) th.join();
+    cout << "Concurrent: size " << shared.size() << ", find 3999: " << shared.find(3999) << endl;
 
     return 0;
 }